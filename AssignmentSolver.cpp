@@ -0,0 +1,111 @@
+#include "AssignmentSolver.h"
+#include <algorithm>
+#include <climits>
+
+namespace
+{
+// Min-cost assignment (Hungarian method with potentials) on a row-major
+// rows x cols matrix with rows <= cols. Returns the column for each row.
+std::vector<int> hungarian(const std::vector<long long> &cost, int rows, int cols)
+{
+    const long long INF = LLONG_MAX / 4;
+    std::vector<long long> u(rows + 1, 0);
+    std::vector<long long> v(cols + 1, 0);
+    std::vector<int> match(cols + 1, 0); // column -> row (1-based), 0 = free
+    std::vector<int> way(cols + 1, 0);
+    std::vector<long long> minSlack(cols + 1);
+    std::vector<bool> used(cols + 1);
+
+    for (int row = 1; row <= rows; ++row)
+    {
+        match[0] = row;
+        int col0 = 0;
+        std::fill(minSlack.begin(), minSlack.end(), INF);
+        std::fill(used.begin(), used.end(), false);
+
+        // Grow an alternating tree from the new row until it reaches a free column
+        do
+        {
+            used[col0] = true;
+            int row0 = match[col0];
+            long long delta = INF;
+            int col1 = 0;
+            const long long *rowCost = &cost[(size_t)(row0 - 1) * cols];
+            for (int col = 1; col <= cols; ++col)
+            {
+                if (used[col])
+                {
+                    continue;
+                }
+                long long slack = rowCost[col - 1] - u[row0] - v[col];
+                if (slack < minSlack[col])
+                {
+                    minSlack[col] = slack;
+                    way[col] = col0;
+                }
+                if (minSlack[col] < delta)
+                {
+                    delta = minSlack[col];
+                    col1 = col;
+                }
+            }
+            for (int col = 0; col <= cols; ++col)
+            {
+                if (used[col])
+                {
+                    u[match[col]] += delta;
+                    v[col] -= delta;
+                }
+                else
+                {
+                    minSlack[col] -= delta;
+                }
+            }
+            col0 = col1;
+        } while (match[col0] != 0);
+
+        // Flip the augmenting path
+        do
+        {
+            int col1 = way[col0];
+            match[col0] = match[col1];
+            col0 = col1;
+        } while (col0 != 0);
+    }
+
+    std::vector<int> result(rows, -1);
+    for (int col = 1; col <= cols; ++col)
+    {
+        if (match[col] != 0)
+        {
+            result[match[col] - 1] = col - 1;
+        }
+    }
+    return result;
+}
+} // namespace
+
+std::vector<int> solveAssignment(const std::vector<long long> &cost, int rows, int cols)
+{
+    if (rows <= cols)
+    {
+        return hungarian(cost, rows, cols);
+    }
+
+    std::vector<long long> transposed((size_t)rows * cols);
+    for (int row = 0; row < rows; ++row)
+    {
+        for (int col = 0; col < cols; ++col)
+        {
+            transposed[(size_t)col * rows + row] = cost[(size_t)row * cols + col];
+        }
+    }
+    std::vector<int> byCol = hungarian(transposed, cols, rows);
+
+    std::vector<int> result(rows, -1);
+    for (int col = 0; col < cols; ++col)
+    {
+        result[byCol[col]] = col;
+    }
+    return result;
+}
@@ -0,0 +1,12 @@
+#ifndef ASSIGNMENTSOLVER_H
+#define ASSIGNMENTSOLVER_H
+
+#include <vector>
+
+// Minimum-cost assignment on a row-major rows x cols cost matrix (Hungarian
+// method, O(min^2 * max) for the smaller and larger dimension). Returns the
+// column chosen for each row, every column used at most once; when there
+// are more rows than columns the rows left over get -1.
+std::vector<int> solveAssignment(const std::vector<long long> &cost, int rows, int cols);
+
+#endif // ASSIGNMENTSOLVER_H
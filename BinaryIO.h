@@ -0,0 +1,109 @@
+#ifndef BINARYIO_H
+#define BINARYIO_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Helpers for the event log and snapshot files: values are appended to a
+// byte buffer in native layout and read back with bounds checks.
+namespace binaryio
+{
+template <class T>
+inline void put(std::vector<char> &out, T value)
+{
+    const char *bytes = reinterpret_cast<const char *>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+inline void putString(std::vector<char> &out, const std::string &value)
+{
+    put<std::uint32_t>(out, (std::uint32_t)value.size());
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+// False, leaving pos alone, if fewer than sizeof(T) bytes remain
+template <class T>
+inline bool get(const char *data, size_t size, size_t &pos, T &value)
+{
+    if (size - pos < sizeof(T))
+    {
+        return false;
+    }
+    std::memcpy(&value, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+inline bool getString(const char *data, size_t size, size_t &pos, std::string &value)
+{
+    std::uint32_t length = 0;
+    if (!get(data, size, pos, length) || size - pos < length)
+    {
+        return false;
+    }
+    value.assign(data + pos, length);
+    pos += length;
+    return true;
+}
+
+// FNV-1a, used as a record checksum
+inline std::uint32_t checksum(const char *data, size_t size)
+{
+    std::uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Flush stdio buffers and force the file's contents to disk
+inline bool syncFile(std::FILE *file)
+{
+    if (std::fflush(file) != 0)
+    {
+        return false;
+    }
+#if defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Force the directory holding path to disk, so a file just created or
+// renamed there survives a crash. Windows has no directory handle to sync;
+// callers rename with MoveFileEx's write-through there instead.
+inline bool syncDirectoryOf(const std::string &path)
+{
+#if defined(_WIN32)
+    (void)path;
+    return true;
+#else
+    std::string::size_type slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int descriptor = ::open(directory.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return false;
+    }
+    bool ok = fsync(descriptor) == 0;
+    ::close(descriptor);
+    return ok;
+#endif
+}
+} // namespace binaryio
+
+#endif // BINARYIO_H
@@ -1,8 +1,13 @@
 #include "City.h"
+#include "DistanceScan.h"
+#include "SearchWorkspace.h"
+#include "ThreadPool.h"
 #include <algorithm>
 #include <iostream>
 
-City::City() : nextNodeId(0) {}
+City::City()
+    : nextNodeId(0), frozen(false), graphVersion(0), routingMode(ROUTE_BIDIRECTIONAL),
+      landmarkCount(8), crossCheck(false), crossCheckFailures(0), distanceCache(4096) {}
 
 int City::addLocation(const std::string &name, int zoneID)
 {
@@ -13,6 +18,32 @@ int City::addLocation(const std::string &name, int zoneID)
 
     nodes.push_back(newNode);
     adjacencyList.resize(nextNodeId + 1);
+    frozen = false;
+    ++graphVersion;
+    nextSameName.push_back(-1);
+
+    std::unordered_map<std::string, int>::iterator found = nameIndex.find(name);
+    if (found == nameIndex.end())
+    {
+        nameIndex[name] = nextNodeId;
+    }
+    else
+    {
+        // Keep the first registration as the default match and chain the new one
+        int last = found->second;
+        while (nextSameName[last] != -1)
+        {
+            last = nextSameName[last];
+        }
+        nextSameName[last] = nextNodeId;
+
+        if (last == found->second)
+        {
+            duplicateNames.push_back(name);
+        }
+        std::cerr << "Warning: Location name '" << name << "' already registered (node "
+                  << found->second << "), name lookups resolve to the first one\n";
+    }
 
     return nextNodeId++;
 }
@@ -28,6 +59,17 @@ void City::addRoad(const std::string &locationA, const std::string &locationB, i
         return;
     }
 
+    addRoad(idA, idB, distance);
+}
+
+void City::addRoad(int idA, int idB, int distance)
+{
+    if (idA < 0 || idB < 0 || idA >= (int)nodes.size() || idB >= (int)nodes.size())
+    {
+        std::cerr << "Error: One or both locations not found\n";
+        return;
+    }
+
     // Add bidirectional edges
     Edge edgeA;
     edgeA.destination = idB;
@@ -38,20 +80,54 @@ void City::addRoad(const std::string &locationA, const std::string &locationB, i
     edgeB.destination = idA;
     edgeB.weight = distance;
     adjacencyList[idB].push_back(edgeB);
+
+    frozen = false;
+    ++graphVersion;
 }
 
 int City::findNodeByName(const std::string &name) const
 {
-    for (size_t i = 0; i < nodes.size(); ++i)
+    std::unordered_map<std::string, int>::const_iterator found = nameIndex.find(name);
+    if (found == nameIndex.end())
     {
-        if (nodes[i].name == name)
+        return -1;
+    }
+    return found->second;
+}
+
+int City::findNodeByName(const std::string &name, int zoneID) const
+{
+    for (int nodeId = findNodeByName(name); nodeId != -1; nodeId = nextSameName[nodeId])
+    {
+        if (nodes[nodeId].zoneID == zoneID)
         {
-            return nodes[i].id;
+            return nodeId;
         }
     }
     return -1;
 }
 
+std::vector<int> City::findNodesByName(const std::string &name) const
+{
+    std::vector<int> result;
+    for (int nodeId = findNodeByName(name); nodeId != -1; nodeId = nextSameName[nodeId])
+    {
+        result.push_back(nodeId);
+    }
+    return result;
+}
+
+bool City::isAmbiguousName(const std::string &name) const
+{
+    int nodeId = findNodeByName(name);
+    return nodeId != -1 && nextSameName[nodeId] != -1;
+}
+
+const std::vector<std::string> &City::getDuplicateNames() const
+{
+    return duplicateNames;
+}
+
 const Node &City::getNode(int nodeId) const
 {
     return nodes[nodeId];
@@ -59,12 +135,31 @@ const Node &City::getNode(int nodeId) const
 
 int City::getZoneByName(const std::string &name) const
 {
-    int nodeId = findNodeByName(name);
-    if (nodeId != -1)
+    return getZone(findNodeByName(name));
+}
+
+int City::getZone(int nodeId) const
+{
+    if (nodeId < 0 || nodeId >= (int)nodes.size())
     {
-        return nodes[nodeId].zoneID;
+        return -1;
     }
-    return -1;
+    return nodes[nodeId].zoneID;
+}
+
+const std::vector<Edge> &City::getRoads(int nodeId) const
+{
+    return adjacencyList[nodeId];
+}
+
+const std::string &City::getLocationName(int nodeId) const
+{
+    static const std::string unknown = "Unknown";
+    if (nodeId < 0 || nodeId >= (int)nodes.size())
+    {
+        return unknown;
+    }
+    return nodes[nodeId].name;
 }
 
 int City::getShortestDistance(const std::string &from, const std::string &to) const
@@ -77,52 +172,415 @@ int City::getShortestDistance(const std::string &from, const std::string &to) co
         return -1;
     }
 
-    // Dijkstra's Algorithm without std::map
-    std::vector<int> dist(nodes.size(), INT_MAX);
-    std::vector<bool> visited(nodes.size(), false);
+    return getShortestDistance(startId, endId);
+}
 
-    dist[startId] = 0;
+int City::getShortestDistance(int startId, int endId) const
+{
+    if (startId < 0 || endId < 0 || startId >= (int)nodes.size() || endId >= (int)nodes.size())
+    {
+        return -1;
+    }
+
+    int distance;
+    if (distanceCache.lookup(startId, endId, graphVersion, distance))
+    {
+        return distance;
+    }
+
+    distance = computeDistance(startId, endId);
+    distanceCache.store(startId, endId, graphVersion, distance);
+    return distance;
+}
 
-    // Process all nodes
-    for (size_t count = 0; count < nodes.size(); ++count)
+DistanceTable City::getDistanceTable(const std::vector<int> &sources, const std::vector<int> &targets) const
+{
+    DistanceTable table;
+    table.rows = (int)sources.size();
+    table.cols = (int)targets.size();
+    table.distances.assign(sources.size() * targets.size(), -1);
+    if (sources.empty() || targets.empty())
     {
-        // Find unvisited node with minimum distance
-        int minDist = INT_MAX;
-        int minNode = -1;
+        return table;
+    }
+
+    freeze();
+
+    if (routingMode == ROUTE_CONTRACTION_HIERARCHY && hierarchy.isCurrent(*this))
+    {
+        hierarchy.distanceTable(sources, targets, table.distances);
+        return table;
+    }
+
+    // Roads are bidirectional, so scan from whichever side is smaller
+    bool fromTargets = targets.size() < sources.size();
+    const std::vector<int> &origins = fromTargets ? targets : sources;
+    const std::vector<int> &ends = fromTargets ? sources : targets;
+    int nodeCount = (int)nodes.size();
 
-        for (size_t i = 0; i < nodes.size(); ++i)
+    // (node, index) pairs sorted by node, so each settled node finds its entries by binary search
+    std::vector<std::pair<int, int>> wanted;
+    for (size_t i = 0; i < ends.size(); ++i)
+    {
+        if (ends[i] >= 0 && ends[i] < nodeCount)
         {
-            if (!visited[i] && dist[i] < minDist)
+            wanted.push_back(std::make_pair(ends[i], (int)i));
+        }
+    }
+    std::sort(wanted.begin(), wanted.end());
+    size_t wantedNodes = 0;
+    for (size_t i = 0; i < wanted.size(); ++i)
+    {
+        if (i == 0 || wanted[i].first != wanted[i - 1].first)
+        {
+            ++wantedNodes;
+        }
+    }
+
+    // Scan each distinct origin once; repeats copy the first one's results
+    std::vector<size_t> unique;
+    std::vector<std::pair<size_t, size_t>> repeats; // (index, index of first occurrence)
+    std::unordered_map<int, size_t> firstIndex;
+    for (size_t i = 0; i < origins.size(); ++i)
+    {
+        if (origins[i] < 0 || origins[i] >= nodeCount || wanted.empty())
+        {
+            continue;
+        }
+        std::unordered_map<int, size_t>::const_iterator seen = firstIndex.find(origins[i]);
+        if (seen == firstIndex.end())
+        {
+            firstIndex[origins[i]] = i;
+            unique.push_back(i);
+        }
+        else
+        {
+            repeats.push_back(std::make_pair(i, seen->second));
+        }
+    }
+
+    size_t cols = targets.size();
+    std::vector<int> &out = table.distances;
+
+    // Scans are independent and each writes only its own row (or column)
+    ThreadPool::shared().parallelFor(0, unique.size(), 1, [&](size_t low, size_t high)
+    {
+        for (size_t u = low; u < high; ++u)
+        {
+            size_t i = unique[u];
+            size_t remaining = wantedNodes;
+            DistanceScan scan(*this, origins[i]);
+            int node;
+            int distance;
+            while (remaining > 0 && scan.next(node, distance))
             {
-                minDist = dist[i];
-                minNode = i;
+                std::vector<std::pair<int, int>>::const_iterator it =
+                    std::lower_bound(wanted.begin(), wanted.end(), std::make_pair(node, -1));
+                if (it == wanted.end() || it->first != node)
+                {
+                    continue;
+                }
+                --remaining;
+                for (; it != wanted.end() && it->first == node; ++it)
+                {
+                    size_t j = it->second;
+                    out[fromTargets ? j * cols + i : i * cols + j] = distance;
+                }
             }
         }
+    });
+
+    for (size_t r = 0; r < repeats.size(); ++r)
+    {
+        size_t i = repeats[r].first;
+        size_t first = repeats[r].second;
+        for (size_t j = 0; j < ends.size(); ++j)
+        {
+            out[fromTargets ? j * cols + i : i * cols + j] = out[fromTargets ? j * cols + first : first * cols + j];
+        }
+    }
+
+    return table;
+}
+
+int City::computeDistance(int startId, int endId) const
+{
+    freeze();
+
+    int distance;
+    switch (routingMode)
+    {
+    case ROUTE_BIDIRECTIONAL:
+        distance = bidirectionalDistance(startId, endId);
+        break;
+
+    case ROUTE_CONTRACTION_HIERARCHY:
+        if (!hierarchy.isCurrent(*this))
+        {
+            return dijkstraDistance(startId, endId);
+        }
+        distance = hierarchy.query(startId, endId);
+        break;
+
+    case ROUTE_ALT:
+        refreshLandmarks();
+        distance = landmarkIndex.query(*this, startId, endId);
+        break;
+
+    default:
+        return dijkstraDistance(startId, endId);
+    }
+
+    return crossCheck ? verifyDistance(startId, endId, distance) : distance;
+}
 
-        if (minNode == -1 || minDist == INT_MAX)
+int City::bidirectionalDistance(int startId, int endId) const
+{
+    if (startId == endId)
+    {
+        return 0;
+    }
+
+    SearchWorkspace::Lease forward(nodes.size());
+    SearchWorkspace::Lease backward(nodes.size());
+    SearchWorkspace *search[2] = {&*forward, &*backward};
+
+    search[0]->setDistance(startId, 0);
+    search[0]->frontier().pushOrDecrease(startId, 0);
+    search[1]->setDistance(endId, 0);
+    search[1]->frontier().pushOrDecrease(endId, 0);
+
+    int best = INT_MAX;
+    while (!search[0]->frontier().empty() && !search[1]->frontier().empty())
+    {
+        // Any path still undiscovered is at least as long as the two smallest keys together
+        int forwardKey = search[0]->frontier().topKey();
+        int backwardKey = search[1]->frontier().topKey();
+        if (best != INT_MAX && forwardKey + backwardKey >= best)
         {
             break;
         }
 
-        visited[minNode] = true;
+        int side = forwardKey <= backwardKey ? 0 : 1;
+        SearchWorkspace &self = *search[side];
+        const SearchWorkspace &other = *search[1 - side];
+        int currentDist = side == 0 ? forwardKey : backwardKey;
+        int current = self.frontier().pop();
+
+        // Roads are bidirectional, so both searches use the same edges
+        for (int e = edgeOffsets[current]; e < edgeOffsets[current + 1]; ++e)
+        {
+            int neighbor = edgeTargets[e];
+            int candidate = currentDist + edgeWeights[e];
+            if (candidate < self.getDistance(neighbor))
+            {
+                self.setDistance(neighbor, candidate);
+                self.frontier().pushOrDecrease(neighbor, candidate);
+            }
+
+            // Track the best meeting point through this edge
+            int otherDist = other.getDistance(neighbor);
+            if (otherDist != INT_MAX && candidate + otherDist < best)
+            {
+                best = candidate + otherDist;
+            }
+        }
+    }
+
+    return best == INT_MAX ? -1 : best;
+}
+
+int City::verifyDistance(int startId, int endId, int distance) const
+{
+    int expected = dijkstraDistance(startId, endId);
+    if (distance != expected)
+    {
+        ++crossCheckFailures;
+        std::cerr << "Error: Routing cross-check failed for " << startId << " -> " << endId
+                  << ": got " << distance << ", Dijkstra " << expected << "\n";
+    }
+    return expected;
+}
+
+int City::dijkstraDistance(int startId, int endId) const
+{
+    freeze();
+
+    SearchWorkspace::Lease search(nodes.size());
+    IndexedHeap &frontier = search->frontier();
+
+    search->setDistance(startId, 0);
+    frontier.pushOrDecrease(startId, 0);
 
-        // Update distances of neighbors
-        for (const Edge &edge : adjacencyList[minNode])
+    while (!frontier.empty())
+    {
+        int currentDist = frontier.topKey();
+        int current = frontier.pop();
+
+        // Settled distances are final, so stop as soon as the target is popped
+        if (current == endId)
         {
-            int neighbor = edge.destination;
-            int weight = edge.weight;
+            return currentDist;
+        }
 
-            if (!visited[neighbor] && dist[minNode] + weight < dist[neighbor])
+        for (int e = edgeOffsets[current]; e < edgeOffsets[current + 1]; ++e)
+        {
+            int neighbor = edgeTargets[e];
+            int candidate = currentDist + edgeWeights[e];
+            if (candidate < search->getDistance(neighbor))
             {
-                dist[neighbor] = dist[minNode] + weight;
+                search->setDistance(neighbor, candidate);
+                frontier.pushOrDecrease(neighbor, candidate);
             }
         }
     }
 
-    return dist[endId] == INT_MAX ? -1 : dist[endId];
+    return -1;
 }
 
 const std::vector<Node> &City::getAllNodes() const
 {
     return nodes;
 }
+
+void City::freeze() const
+{
+    // Queries from several threads may race to build the arrays; one does it
+    if (frozen.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(freezeMutex);
+    if (frozen.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    size_t edgeCount = 0;
+    for (size_t i = 0; i < adjacencyList.size(); ++i)
+    {
+        edgeCount += adjacencyList[i].size();
+    }
+
+    edgeOffsets.assign(nodes.size() + 1, 0);
+    edgeTargets.resize(edgeCount);
+    edgeWeights.resize(edgeCount);
+
+    int cursor = 0;
+    for (size_t i = 0; i < adjacencyList.size(); ++i)
+    {
+        edgeOffsets[i] = cursor;
+        for (const Edge &edge : adjacencyList[i])
+        {
+            edgeTargets[cursor] = edge.destination;
+            edgeWeights[cursor] = edge.weight;
+            ++cursor;
+        }
+    }
+    edgeOffsets[nodes.size()] = cursor;
+
+    frozen.store(true, std::memory_order_release);
+}
+
+bool City::isFrozen() const
+{
+    return frozen;
+}
+
+unsigned long City::getGraphVersion() const
+{
+    return graphVersion;
+}
+
+unsigned long long City::computeFingerprint() const
+{
+    freeze();
+
+    // FNV-1a over the node count and CSR arrays
+    unsigned long long hash = 14695981039346656037ULL;
+    const unsigned long long prime = 1099511628211ULL;
+
+    hash = (hash ^ (unsigned long long)nodes.size()) * prime;
+    for (size_t i = 0; i < edgeOffsets.size(); ++i)
+    {
+        hash = (hash ^ (unsigned long long)edgeOffsets[i]) * prime;
+    }
+    for (size_t i = 0; i < edgeTargets.size(); ++i)
+    {
+        hash = (hash ^ (unsigned long long)edgeTargets[i]) * prime;
+        hash = (hash ^ (unsigned long long)edgeWeights[i]) * prime;
+    }
+    return hash;
+}
+
+void City::setRoutingMode(RoutingMode mode)
+{
+    routingMode = mode;
+}
+
+RoutingMode City::getRoutingMode() const
+{
+    return routingMode;
+}
+
+void City::buildContractionHierarchy()
+{
+    hierarchy.build(*this);
+}
+
+bool City::saveContractionHierarchy(const std::string &path) const
+{
+    return hierarchy.save(path);
+}
+
+bool City::loadContractionHierarchy(const std::string &path)
+{
+    return hierarchy.load(path, *this);
+}
+
+const ContractionHierarchy &City::getContractionHierarchy() const
+{
+    return hierarchy;
+}
+
+void City::buildLandmarks(int count)
+{
+    std::lock_guard<std::mutex> lock(landmarkMutex);
+    landmarkCount = count;
+    landmarkIndex.build(*this, count);
+}
+
+void City::refreshLandmarks() const
+{
+    // The first query after a network change rebuilds; concurrent ones wait for it
+    std::lock_guard<std::mutex> lock(landmarkMutex);
+    if (!landmarkIndex.isCurrent(*this))
+    {
+        landmarkIndex.build(*this, landmarkCount);
+    }
+}
+
+const LandmarkIndex &City::getLandmarkIndex() const
+{
+    return landmarkIndex;
+}
+
+void City::setDistanceCacheCapacity(size_t entries)
+{
+    distanceCache.setCapacity(entries);
+}
+
+const DistanceCache &City::getDistanceCache() const
+{
+    return distanceCache;
+}
+
+void City::setCrossCheck(bool enabled)
+{
+    crossCheck = enabled;
+}
+
+size_t City::getCrossCheckFailures() const
+{
+    return crossCheckFailures;
+}
@@ -4,6 +4,12 @@
 #include <string>
 #include <vector>
 #include <climits>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include "ContractionHierarchy.h"
+#include "LandmarkIndex.h"
+#include "DistanceCache.h"
 
 struct Node
 {
@@ -18,13 +24,94 @@ struct Edge
     int weight;
 };
 
+// A named city and the location names listed under it in menus
+struct CityInfo
+{
+    int cityId;
+    std::string cityName;
+    std::vector<std::string> locations;
+};
+
+// Result of City::getDistanceTable, stored row-major in one block:
+// distances[row * cols + col] runs from sources[row] to targets[col],
+// -1 if unreachable or either ID is invalid
+struct DistanceTable
+{
+    int rows;
+    int cols;
+    std::vector<int> distances;
+
+    int at(int row, int col) const { return distances[(size_t)row * cols + col]; }
+};
+
+// Algorithm used by City::getShortestDistance for point-to-point queries
+enum RoutingMode
+{
+    ROUTE_DIJKSTRA,
+    ROUTE_BIDIRECTIONAL, // Default: no preprocessing, suits frequently changing networks
+    ROUTE_CONTRACTION_HIERARCHY,
+    ROUTE_ALT
+};
+
+// Queries (distances, tables, lookups) may run on many threads at once.
+// Changes to the network and index builds must not overlap with them.
 class City
 {
+    friend class DistanceScan;
+    friend class ContractionHierarchy;
+    friend class LandmarkIndex;
+
 private:
     std::vector<Node> nodes;
-    std::vector<std::vector<Edge>> adjacencyList;
+    std::vector<std::vector<Edge>> adjacencyList; // Mutable builder, edited by addRoad
     int nextNodeId;
 
+    // Compressed sparse row copy of adjacencyList that all queries run on.
+    // Edges of node u occupy [edgeOffsets[u], edgeOffsets[u + 1]) in the
+    // target and weight arrays. Rebuilt lazily after the network changes.
+    mutable std::vector<int> edgeOffsets;
+    mutable std::vector<int> edgeTargets;
+    mutable std::vector<int> edgeWeights;
+    mutable std::atomic<bool> frozen;
+    mutable std::mutex freezeMutex;
+
+    // Incremented by every change to the road network
+    unsigned long graphVersion;
+
+    RoutingMode routingMode;
+    ContractionHierarchy hierarchy;
+    // Rebuilt on demand by ROUTE_ALT queries after the network changes
+    mutable LandmarkIndex landmarkIndex;
+    mutable std::mutex landmarkMutex;
+    int landmarkCount;
+    bool crossCheck;
+    mutable std::atomic<size_t> crossCheckFailures;
+
+    // Recently answered point-to-point queries, dropped on any network change
+    mutable DistanceCache distanceCache;
+
+    // Plain heap-based Dijkstra with early exit, the reference for every other mode
+    int dijkstraDistance(int startId, int endId) const;
+
+    // Rebuild the landmark index if the network changed since it was built
+    void refreshLandmarks() const;
+
+    // Run the current routing mode without consulting the cache
+    int computeDistance(int startId, int endId) const;
+
+    // Dijkstra from both ends at once, stopping when the frontiers meet
+    int bidirectionalDistance(int startId, int endId) const;
+
+    // Cross-check an accelerated answer against Dijkstra, returning the correct one
+    int verifyDistance(int startId, int endId, int distance) const;
+
+    // Name -> first node registered under that name
+    std::unordered_map<std::string, int> nameIndex;
+    // Node -> next node sharing the same name, -1 at end of chain
+    std::vector<int> nextSameName;
+    // Names registered more than once, in order of first collision
+    std::vector<std::string> duplicateNames;
+
 public:
     City();
 
@@ -33,21 +120,89 @@ public:
 
     // Add a road (bidirectional edge) between two locations
     void addRoad(const std::string &locationA, const std::string &locationB, int distance);
+    void addRoad(int idA, int idB, int distance);
 
-    // Find node by name, returns -1 if not found
+    // Find node by name in O(1), returns -1 if not found
+    // Duplicate names resolve to the first location registered
     int findNodeByName(const std::string &name) const;
 
+    // Find the node with this name in a specific zone, returns -1 if not found
+    int findNodeByName(const std::string &name, int zoneID) const;
+
+    // All node IDs registered under a name, in registration order
+    std::vector<int> findNodesByName(const std::string &name) const;
+
+    // True if more than one location was registered under this name
+    bool isAmbiguousName(const std::string &name) const;
+
+    // Names that were registered more than once
+    const std::vector<std::string> &getDuplicateNames() const;
+
     // Get node by ID
     const Node &getNode(int nodeId) const;
 
     // Get zone ID for a location by name
     int getZoneByName(const std::string &name) const;
 
+    // Get zone ID for a node, returns -1 if the ID is invalid
+    int getZone(int nodeId) const;
+
+    // Display name for a node, "Unknown" if the ID is invalid
+    const std::string &getLocationName(int nodeId) const;
+
     // Dijkstra's algorithm to find shortest distance between two locations
     int getShortestDistance(const std::string &from, const std::string &to) const;
 
+    // Shortest distance between two node IDs using the current routing mode
+    // Returns -1 if either node is invalid or unreachable
+    int getShortestDistance(int startId, int endId) const;
+
+    // Shortest distances from every source to every target in one call.
+    // Uses the hierarchy's bucket search when ROUTE_CONTRACTION_HIERARCHY is
+    // current, otherwise one incremental Dijkstra per distinct node on the
+    // smaller side, each stopping once the other side is settled
+    DistanceTable getDistanceTable(const std::vector<int> &sources, const std::vector<int> &targets) const;
+
+    // Select the algorithm used by getShortestDistance
+    // Modes whose index is missing or out of date fall back to Dijkstra
+    void setRoutingMode(RoutingMode mode);
+    RoutingMode getRoutingMode() const;
+
+    // Contraction Hierarchies index for ROUTE_CONTRACTION_HIERARCHY
+    void buildContractionHierarchy();
+    bool saveContractionHierarchy(const std::string &path) const;
+    bool loadContractionHierarchy(const std::string &path);
+    const ContractionHierarchy &getContractionHierarchy() const;
+
+    // Landmark index for ROUTE_ALT; count is kept for automatic rebuilds
+    void buildLandmarks(int count);
+    const LandmarkIndex &getLandmarkIndex() const;
+
+    // Point-to-point result cache (hit/miss counters, capacity in pairs)
+    void setDistanceCacheCapacity(size_t entries);
+    const DistanceCache &getDistanceCache() const;
+
+    // Verify every accelerated query against plain Dijkstra
+    // Mismatches are reported on stderr and the Dijkstra answer is returned
+    void setCrossCheck(bool enabled);
+    size_t getCrossCheckFailures() const;
+
     // Get all node IDs
     const std::vector<Node> &getAllNodes() const;
+    // Roads leaving a node, as added (each road is listed at both ends)
+    const std::vector<Edge> &getRoads(int nodeId) const;
+
+    // Compact the road network into CSR arrays for querying
+    // Queries call this automatically after addLocation/addRoad
+    void freeze() const;
+
+    bool isFrozen() const;
+
+    // Changes whenever a location or road is added
+    unsigned long getGraphVersion() const;
+
+    // Content hash of the road network, stable across runs
+    unsigned long long computeFingerprint() const;
 };
 
 #endif // CITY_H
@@ -0,0 +1,613 @@
+#include "ContractionHierarchy.h"
+#include "City.h"
+#include "IndexedHeap.h"
+#include "SearchWorkspace.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+const char FILE_MAGIC[4] = {'R', 'S', 'C', 'H'};
+const int FILE_VERSION = 1;
+
+// Witness searches give up after settling this many nodes and add the
+// shortcut anyway; extra shortcuts cost space but never correctness
+const int WITNESS_SETTLE_LIMIT = 500;
+// Cheaper limit used when only estimating a node's priority
+const int SIMULATE_SETTLE_LIMIT = 50;
+
+// Entry left at a node by a target's upward search
+struct BucketEntry
+{
+    int node;
+    int column;
+    int distance;
+
+    bool operator<(const BucketEntry &other) const
+    {
+        return node < other.node;
+    }
+};
+
+struct WorkEdge
+{
+    int target;
+    int weight;
+};
+
+// Mutable state of the preprocessing pass
+class Contractor
+{
+public:
+    std::vector<std::vector<WorkEdge>> graph; // Remaining uncontracted graph
+    std::vector<std::vector<WorkEdge>> upward; // Edges kept once a node is contracted
+    std::vector<int> deletedNeighbors;
+    size_t shortcutCount;
+
+    std::vector<int> dist;
+    std::vector<int> touched;
+    std::vector<bool> isTarget;
+    IndexedHeap heap;
+
+    explicit Contractor(size_t nodeCount)
+        : graph(nodeCount), upward(nodeCount), deletedNeighbors(nodeCount, 0),
+          shortcutCount(0), dist(nodeCount, INT_MAX), isTarget(nodeCount, false)
+    {
+        heap.resize(nodeCount);
+    }
+
+    void addOrLowerEdge(int from, int to, int weight)
+    {
+        for (WorkEdge &edge : graph[from])
+        {
+            if (edge.target == to)
+            {
+                if (weight < edge.weight)
+                {
+                    edge.weight = weight;
+                }
+                return;
+            }
+        }
+        WorkEdge edge;
+        edge.target = to;
+        edge.weight = weight;
+        graph[from].push_back(edge);
+    }
+
+    // Bounded Dijkstra from source that never passes through skip
+    // Stops early once all targetCount nodes flagged in isTarget are settled
+    void witnessSearch(int source, int skip, int maxDist, int settleLimit, int targetCount)
+    {
+        dist[source] = 0;
+        touched.push_back(source);
+        heap.pushOrDecrease(source, 0);
+
+        int settled = 0;
+        while (!heap.empty() && heap.topKey() <= maxDist && settled < settleLimit && targetCount > 0)
+        {
+            int node = heap.pop();
+            ++settled;
+            if (isTarget[node])
+            {
+                --targetCount;
+            }
+
+            for (const WorkEdge &edge : graph[node])
+            {
+                if (edge.target == skip)
+                {
+                    continue;
+                }
+                int candidate = dist[node] + edge.weight;
+                if (candidate < dist[edge.target])
+                {
+                    if (dist[edge.target] == INT_MAX)
+                    {
+                        touched.push_back(edge.target);
+                    }
+                    dist[edge.target] = candidate;
+                    heap.pushOrDecrease(edge.target, candidate);
+                }
+            }
+        }
+    }
+
+    void resetWitness()
+    {
+        for (int node : touched)
+        {
+            dist[node] = INT_MAX;
+        }
+        touched.clear();
+        heap.clear();
+    }
+
+    // Count (and optionally insert) the shortcuts needed to remove node
+    int processShortcuts(int node, bool add, int settleLimit)
+    {
+        // Copy: inserting shortcuts may reallocate the neighbour lists
+        std::vector<WorkEdge> neighbors = graph[node];
+
+        int shortcuts = 0;
+        for (size_t i = 0; i + 1 < neighbors.size(); ++i)
+        {
+            // Each pair is checked once, from the neighbour listed first
+            int maxWeight = 0;
+            for (size_t j = i + 1; j < neighbors.size(); ++j)
+            {
+                isTarget[neighbors[j].target] = true;
+                if (neighbors[j].weight > maxWeight)
+                {
+                    maxWeight = neighbors[j].weight;
+                }
+            }
+
+            int from = neighbors[i].target;
+            witnessSearch(from, node, neighbors[i].weight + maxWeight, settleLimit,
+                          (int)(neighbors.size() - i - 1));
+
+            for (size_t j = i + 1; j < neighbors.size(); ++j)
+            {
+                isTarget[neighbors[j].target] = false;
+            }
+
+            for (size_t j = i + 1; j < neighbors.size(); ++j)
+            {
+                int to = neighbors[j].target;
+                int via = neighbors[i].weight + neighbors[j].weight;
+                if (dist[to] > via)
+                {
+                    ++shortcuts;
+                    if (add)
+                    {
+                        addOrLowerEdge(from, to, via);
+                        addOrLowerEdge(to, from, via);
+                        ++shortcutCount;
+                    }
+                }
+            }
+
+            resetWitness();
+        }
+        return shortcuts;
+    }
+
+    // Edge difference plus a term that spreads contraction evenly over the graph
+    int priority(int node)
+    {
+        int shortcuts = processShortcuts(node, false, SIMULATE_SETTLE_LIMIT);
+        return shortcuts - (int)graph[node].size() + deletedNeighbors[node];
+    }
+
+    void contract(int node)
+    {
+        processShortcuts(node, true, WITNESS_SETTLE_LIMIT);
+
+        // Every remaining neighbour will be contracted later, so it ranks higher
+        upward[node] = graph[node];
+
+        for (const WorkEdge &edge : graph[node])
+        {
+            std::vector<WorkEdge> &other = graph[edge.target];
+            for (size_t i = 0; i < other.size(); ++i)
+            {
+                if (other[i].target == node)
+                {
+                    other[i] = other.back();
+                    other.pop_back();
+                    break;
+                }
+            }
+            deletedNeighbors[edge.target]++;
+        }
+        graph[node].clear();
+    }
+};
+
+template <typename T>
+void writeArray(std::ofstream &out, const std::vector<T> &values)
+{
+    if (!values.empty())
+    {
+        out.write(reinterpret_cast<const char *>(&values[0]), values.size() * sizeof(T));
+    }
+}
+
+template <typename T>
+bool readArray(std::ifstream &in, std::vector<T> &values, size_t count)
+{
+    values.resize(count);
+    if (count > 0)
+    {
+        in.read(reinterpret_cast<char *>(&values[0]), count * sizeof(T));
+    }
+    return (bool)in;
+}
+
+// Queries index straight into the arrays, so a loaded index must be
+// internally consistent: offsets rising from 0 to the edge count, and every
+// target and rank a valid node
+bool isConsistent(const std::vector<int> &rank, const std::vector<int> &upOffsets,
+                  const std::vector<int> &upTargets, const std::vector<int> &upWeights, int nodeCount)
+{
+    if ((int)rank.size() != nodeCount || (int)upOffsets.size() != nodeCount + 1 ||
+        upTargets.size() != upWeights.size() || upOffsets[0] != 0 || upOffsets[nodeCount] != (int)upTargets.size())
+    {
+        return false;
+    }
+    std::vector<bool> seenRank(nodeCount, false);
+    for (int node = 0; node < nodeCount; ++node)
+    {
+        if (upOffsets[node] > upOffsets[node + 1] || rank[node] < 0 || rank[node] >= nodeCount || seenRank[rank[node]])
+        {
+            return false;
+        }
+        seenRank[rank[node]] = true;
+    }
+    for (size_t e = 0; e < upTargets.size(); ++e)
+    {
+        if (upTargets[e] < 0 || upTargets[e] >= nodeCount || upWeights[e] < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+ContractionHierarchy::ContractionHierarchy()
+    : shortcutCount(0), fingerprint(0), graphVersion(0), built(false) {}
+
+void ContractionHierarchy::build(const City &city)
+{
+    city.freeze();
+    size_t nodeCount = city.nodes.size();
+
+    Contractor contractor(nodeCount);
+    for (size_t node = 0; node < nodeCount; ++node)
+    {
+        for (int e = city.edgeOffsets[node]; e < city.edgeOffsets[node + 1]; ++e)
+        {
+            if (city.edgeTargets[e] != (int)node)
+            {
+                contractor.addOrLowerEdge((int)node, city.edgeTargets[e], city.edgeWeights[e]);
+            }
+        }
+    }
+
+    IndexedHeap queue;
+    queue.resize(nodeCount);
+    for (size_t node = 0; node < nodeCount; ++node)
+    {
+        queue.pushOrUpdate((int)node, contractor.priority((int)node));
+    }
+
+    rank.assign(nodeCount, 0);
+    int order = 0;
+    while (!queue.empty())
+    {
+        int node = queue.pop();
+
+        // Lazy update: priorities go stale as neighbours are contracted
+        int current = contractor.priority(node);
+        if (!queue.empty() && current > queue.topKey())
+        {
+            queue.pushOrUpdate(node, current);
+            continue;
+        }
+
+        contractor.contract(node);
+        rank[node] = order++;
+
+        for (const WorkEdge &edge : contractor.upward[node])
+        {
+            queue.pushOrUpdate(edge.target, contractor.priority(edge.target));
+        }
+    }
+
+    upOffsets.assign(nodeCount + 1, 0);
+    upTargets.clear();
+    upWeights.clear();
+    for (size_t node = 0; node < nodeCount; ++node)
+    {
+        upOffsets[node] = (int)upTargets.size();
+        for (const WorkEdge &edge : contractor.upward[node])
+        {
+            upTargets.push_back(edge.target);
+            upWeights.push_back(edge.weight);
+        }
+    }
+    upOffsets[nodeCount] = (int)upTargets.size();
+
+    shortcutCount = contractor.shortcutCount;
+    fingerprint = city.computeFingerprint();
+    graphVersion = city.getGraphVersion();
+    built = true;
+}
+
+void ContractionHierarchy::clear()
+{
+    rank.clear();
+    upOffsets.clear();
+    upTargets.clear();
+    upWeights.clear();
+    shortcutCount = 0;
+    built = false;
+}
+
+bool ContractionHierarchy::isBuilt() const
+{
+    return built;
+}
+
+bool ContractionHierarchy::isCurrent(const City &city) const
+{
+    return built && graphVersion == city.getGraphVersion();
+}
+
+int ContractionHierarchy::query(int startId, int endId) const
+{
+    int nodeCount = (int)rank.size();
+    if (!built || startId < 0 || endId < 0 || startId >= nodeCount || endId >= nodeCount)
+    {
+        return -1;
+    }
+    if (startId == endId)
+    {
+        return 0;
+    }
+
+    SearchWorkspace::Lease forward(nodeCount);
+    SearchWorkspace::Lease backward(nodeCount);
+    SearchWorkspace *search[2] = {&*forward, &*backward};
+
+    search[0]->setDistance(startId, 0);
+    search[0]->frontier().pushOrDecrease(startId, 0);
+    search[1]->setDistance(endId, 0);
+    search[1]->frontier().pushOrDecrease(endId, 0);
+
+    int best = INT_MAX;
+    while (true)
+    {
+        // A direction is finished once its smallest key cannot improve on best
+        int forwardKey = search[0]->frontier().empty() ? INT_MAX : search[0]->frontier().topKey();
+        int backwardKey = search[1]->frontier().empty() ? INT_MAX : search[1]->frontier().topKey();
+        if (forwardKey >= best && backwardKey >= best)
+        {
+            break;
+        }
+
+        int side = forwardKey <= backwardKey ? 0 : 1;
+        SearchWorkspace &self = *search[side];
+        int nodeDist = side == 0 ? forwardKey : backwardKey;
+        int node = self.frontier().pop();
+
+        int otherDist = search[1 - side]->getDistance(node);
+        if (otherDist != INT_MAX && nodeDist + otherDist < best)
+        {
+            best = nodeDist + otherDist;
+        }
+
+        for (int e = upOffsets[node]; e < upOffsets[node + 1]; ++e)
+        {
+            int neighbor = upTargets[e];
+            int candidate = nodeDist + upWeights[e];
+            if (candidate < self.getDistance(neighbor))
+            {
+                self.setDistance(neighbor, candidate);
+                self.frontier().pushOrDecrease(neighbor, candidate);
+            }
+        }
+    }
+
+    return best == INT_MAX ? -1 : best;
+}
+
+void ContractionHierarchy::upwardSearch(int source, std::vector<std::pair<int, int>> &settled) const
+{
+    int nodeCount = (int)rank.size();
+    SearchWorkspace::Lease search(nodeCount);
+    IndexedHeap &frontier = search->frontier();
+
+    settled.clear();
+    search->setDistance(source, 0);
+    frontier.pushOrDecrease(source, 0);
+    while (!frontier.empty())
+    {
+        int nodeDist = frontier.topKey();
+        int node = frontier.pop();
+        settled.push_back(std::make_pair(node, nodeDist));
+
+        for (int e = upOffsets[node]; e < upOffsets[node + 1]; ++e)
+        {
+            int neighbor = upTargets[e];
+            int candidate = nodeDist + upWeights[e];
+            if (candidate < search->getDistance(neighbor))
+            {
+                search->setDistance(neighbor, candidate);
+                frontier.pushOrDecrease(neighbor, candidate);
+            }
+        }
+    }
+}
+
+void ContractionHierarchy::distanceTable(const std::vector<int> &sources, const std::vector<int> &targets,
+                                         std::vector<int> &table) const
+{
+    int nodeCount = (int)rank.size();
+    if (!built)
+    {
+        return;
+    }
+
+    // Backward phase: bucket every node each target's upward search reaches
+    std::vector<std::vector<BucketEntry>> perTarget(targets.size());
+    ThreadPool::shared().parallelFor(0, targets.size(), 1, [&](size_t low, size_t high)
+    {
+        std::vector<std::pair<int, int>> settled;
+        for (size_t col = low; col < high; ++col)
+        {
+            int target = targets[col];
+            if (target < 0 || target >= nodeCount)
+            {
+                continue;
+            }
+            upwardSearch(target, settled);
+            for (size_t i = 0; i < settled.size(); ++i)
+            {
+                BucketEntry entry = {settled[i].first, (int)col, settled[i].second};
+                perTarget[col].push_back(entry);
+            }
+        }
+    });
+
+    std::vector<BucketEntry> buckets;
+    for (size_t col = 0; col < perTarget.size(); ++col)
+    {
+        buckets.insert(buckets.end(), perTarget[col].begin(), perTarget[col].end());
+    }
+    std::sort(buckets.begin(), buckets.end());
+
+    // Forward phase: every shortest path peaks at a node both searches reach
+    size_t cols = targets.size();
+    ThreadPool::shared().parallelFor(0, sources.size(), 1, [&](size_t low, size_t high)
+    {
+        std::vector<std::pair<int, int>> settled;
+        for (size_t row = low; row < high; ++row)
+        {
+            int source = sources[row];
+            if (source < 0 || source >= nodeCount)
+            {
+                continue;
+            }
+            upwardSearch(source, settled);
+            int *out = &table[row * cols];
+            for (size_t i = 0; i < settled.size(); ++i)
+            {
+                BucketEntry key = {settled[i].first, 0, 0};
+                std::vector<BucketEntry>::const_iterator it = std::lower_bound(buckets.begin(), buckets.end(), key);
+                for (; it != buckets.end() && it->node == key.node; ++it)
+                {
+                    int distance = settled[i].second + it->distance;
+                    if (out[it->column] == -1 || distance < out[it->column])
+                    {
+                        out[it->column] = distance;
+                    }
+                }
+            }
+        }
+    });
+}
+
+size_t ContractionHierarchy::getShortcutCount() const
+{
+    return shortcutCount;
+}
+
+bool ContractionHierarchy::save(const std::string &path) const
+{
+    if (!built)
+    {
+        return false;
+    }
+
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "Error: Cannot write hierarchy file " << path << "\n";
+        return false;
+    }
+
+    int nodeCount = (int)rank.size();
+    int edgeCount = (int)upTargets.size();
+    unsigned long long shortcuts = shortcutCount;
+
+    out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    out.write(reinterpret_cast<const char *>(&FILE_VERSION), sizeof(FILE_VERSION));
+    out.write(reinterpret_cast<const char *>(&fingerprint), sizeof(fingerprint));
+    out.write(reinterpret_cast<const char *>(&nodeCount), sizeof(nodeCount));
+    out.write(reinterpret_cast<const char *>(&edgeCount), sizeof(edgeCount));
+    out.write(reinterpret_cast<const char *>(&shortcuts), sizeof(shortcuts));
+    writeArray(out, rank);
+    writeArray(out, upOffsets);
+    writeArray(out, upTargets);
+    writeArray(out, upWeights);
+
+    return (bool)out;
+}
+
+bool ContractionHierarchy::load(const std::string &path, const City &city)
+{
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in)
+    {
+        return false;
+    }
+
+    char magic[4];
+    int version = 0;
+    unsigned long long savedFingerprint = 0;
+    int nodeCount = 0;
+    int edgeCount = 0;
+    unsigned long long shortcuts = 0;
+
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(&version), sizeof(version));
+    in.read(reinterpret_cast<char *>(&savedFingerprint), sizeof(savedFingerprint));
+    in.read(reinterpret_cast<char *>(&nodeCount), sizeof(nodeCount));
+    in.read(reinterpret_cast<char *>(&edgeCount), sizeof(edgeCount));
+    in.read(reinterpret_cast<char *>(&shortcuts), sizeof(shortcuts));
+
+    if (!in || magic[0] != FILE_MAGIC[0] || magic[1] != FILE_MAGIC[1] ||
+        magic[2] != FILE_MAGIC[2] || magic[3] != FILE_MAGIC[3] || version != FILE_VERSION)
+    {
+        std::cerr << "Error: " << path << " is not a hierarchy file\n";
+        return false;
+    }
+
+    // Refuse an index built for a different road network
+    if (nodeCount != (int)city.getAllNodes().size() || savedFingerprint != city.computeFingerprint())
+    {
+        std::cerr << "Error: Hierarchy file " << path << " does not match the current road network\n";
+        return false;
+    }
+
+    // The header decides how much is read, so check it against the file size
+    // before allocating anything
+    std::streamoff headerEnd = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::streamoff fileSize = in.tellg();
+    in.seekg(headerEnd);
+    if (edgeCount < 0 ||
+        fileSize - headerEnd != (std::streamoff)((2 * (size_t)nodeCount + 1 + 2 * (size_t)edgeCount) * sizeof(int)))
+    {
+        std::cerr << "Error: Hierarchy file " << path << " is truncated or damaged\n";
+        return false;
+    }
+
+    ContractionHierarchy loaded;
+    if (!readArray(in, loaded.rank, nodeCount) ||
+        !readArray(in, loaded.upOffsets, nodeCount + 1) ||
+        !readArray(in, loaded.upTargets, edgeCount) ||
+        !readArray(in, loaded.upWeights, edgeCount))
+    {
+        std::cerr << "Error: Hierarchy file " << path << " is truncated\n";
+        return false;
+    }
+    if (!isConsistent(loaded.rank, loaded.upOffsets, loaded.upTargets, loaded.upWeights, nodeCount))
+    {
+        std::cerr << "Error: Hierarchy file " << path << " is damaged\n";
+        return false;
+    }
+
+    loaded.shortcutCount = (size_t)shortcuts;
+    loaded.fingerprint = savedFingerprint;
+    loaded.graphVersion = city.getGraphVersion();
+    loaded.built = true;
+    *this = loaded;
+    return true;
+}
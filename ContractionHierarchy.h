@@ -0,0 +1,68 @@
+#ifndef CONTRACTIONHIERARCHY_H
+#define CONTRACTIONHIERARCHY_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+class City;
+
+// Contraction Hierarchies index over a City's road network.
+// Preprocessing contracts nodes one at a time (least important first),
+// adding shortcut edges that preserve shortest distances among the
+// remaining nodes. Queries then run a bidirectional Dijkstra that only
+// follows edges towards higher-ranked nodes, settling a tiny fraction of
+// the graph. Roads are bidirectional, so one upward graph serves both
+// search directions.
+class ContractionHierarchy
+{
+private:
+    std::vector<int> rank; // node -> contraction order
+    // Upward graph in CSR form: edges from each node to higher-ranked nodes
+    std::vector<int> upOffsets;
+    std::vector<int> upTargets;
+    std::vector<int> upWeights;
+    size_t shortcutCount;
+    unsigned long long fingerprint; // City::computeFingerprint() of the source graph
+    unsigned long graphVersion;     // City::getGraphVersion() when built or loaded
+    bool built;
+
+    // Exhaustive search over the upward graph; fills (node, distance) in settle order
+    void upwardSearch(int source, std::vector<std::pair<int, int>> &settled) const;
+
+public:
+    ContractionHierarchy();
+
+    // Run the contraction preprocessing for the city's current road network
+    void build(const City &city);
+
+    // Drop the index
+    void clear();
+
+    bool isBuilt() const;
+
+    // True if the index was built or loaded for the city's current network
+    bool isCurrent(const City &city) const;
+
+    // Shortest distance between two node IDs, -1 if unreachable
+    int query(int startId, int endId) const;
+
+    // Many-to-many distances by bucket search: one upward search per target
+    // leaves (target, distance) entries at every node it reaches, and one
+    // upward search per source meets them. table is row-major
+    // sources x targets and must be pre-filled with -1.
+    void distanceTable(const std::vector<int> &sources, const std::vector<int> &targets,
+                       std::vector<int> &table) const;
+
+    // Number of shortcut edges added during preprocessing
+    size_t getShortcutCount() const;
+
+    // Write the index to a binary file so preprocessing can be skipped on startup
+    bool save(const std::string &path) const;
+
+    // Read an index written by save(); fails if it was built for a different network
+    bool load(const std::string &path, const City &city);
+};
+
+#endif // CONTRACTIONHIERARCHY_H
@@ -0,0 +1,46 @@
+#ifndef COSTPOLICY_H
+#define COSTPOLICY_H
+
+#include <climits>
+#include "Driver.h"
+
+// Cost policies for BasicDispatchEngine.
+// A policy is a small copyable type the engine calls inline while scoring
+// drivers, so custom models pay no virtual-call overhead. It provides:
+//
+//   int cost(int distance, const Driver *driver, int pickupZone) const
+//       Cost of sending driver to a pickup distance away (-1 = unreachable).
+//       Lower is better; must stay well below INT_MAX.
+//   int minCost(int distance) const
+//       A lower bound on cost() for every driver at that distance, never
+//       decreasing as distance grows (-1 = unreachable). The engine stops
+//       searching once this bound exceeds the best cost found.
+//   int minOutOfZoneCost(int distance) const
+//       The same bound for drivers outside the pickup zone, letting the
+//       search stop early once every in-zone driver has been seen.
+
+// Default model: road distance plus a flat penalty for crossing zones
+struct ZoneDistanceCost
+{
+    static const int ZONE_PENALTY = 50;
+    // Unreachable drivers still rank (by penalty) without overflowing sums
+    static const int UNREACHABLE = INT_MAX / 2;
+
+    int cost(int distance, const Driver *driver, int pickupZone) const
+    {
+        int base = distance == -1 ? UNREACHABLE : distance;
+        return driver->getZoneID() != pickupZone ? base + ZONE_PENALTY : base;
+    }
+
+    int minCost(int distance) const
+    {
+        return distance == -1 ? UNREACHABLE : distance;
+    }
+
+    int minOutOfZoneCost(int distance) const
+    {
+        return minCost(distance) + ZONE_PENALTY;
+    }
+};
+
+#endif // COSTPOLICY_H
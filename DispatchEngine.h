@@ -3,22 +3,552 @@
 
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <queue>
+#include <unordered_map>
+#include "City.h"
+#include "Driver.h"
+#include "DriverIndex.h"
+#include "DistanceScan.h"
+#include "ThreadPool.h"
+#include "AssignmentSolver.h"
+#include "PendingRequestQueue.h"
+#include "Trip.h"
+#include "CostPolicy.h"
 
-class City;
-class Driver;
+// One ranked driver from a k-nearest query
+struct DriverCandidate
+{
+    Driver *driver;
+    int distance; // Road distance to the pickup
+    int cost;     // Policy cost, the ranking key
+};
 
-class DispatchEngine
+// Driver assignment, parameterised on a cost policy (see CostPolicy.h) so a
+// deployment can plug in its own cost model at compile time; the policy's
+// calls inline into the scoring loops. DispatchEngine is the default
+// distance + zone penalty engine.
+template <class CostPolicy>
+class BasicDispatchEngine
 {
 public:
-    DispatchEngine();
+    explicit BasicDispatchEngine(const CostPolicy &policy = CostPolicy());
+
+    // Find the available driver with the lowest policy cost
+    // Runs a single search outward from the pickup and scores the drivers
+    // the index holds at each settled node, so the cost depends on nearby
+    // supply rather than fleet size. Ties go to the lowest driver ID.
+    Driver *findNearestDriver(City &city, const DriverIndex &index, int pickupLocation);
+
+    // Up to k available drivers with the lowest policy cost, cheapest first,
+    // among those within maxRadius road distance of the pickup. The search
+    // stops once k drivers are held and nothing further out can displace
+    // them, or once it passes maxRadius. Drivers that cannot reach the
+    // pickup are never returned.
+    std::vector<DriverCandidate> findNearestDrivers(const City &city, const DriverIndex &index, int pickupLocation,
+                                                    size_t k, int maxRadius = INT_MAX) const;
+
+    // Reverse match for a driver who just became free: the waiting request
+    // they can serve at the lowest policy cost, longest wait first on ties.
+    // Searches outward from the driver only until no closer pickup could
+    // win, so the work depends on nearby demand rather than backlog size.
+    // If no waiting pickup is reachable, the cheapest unreachable one (longest
+    // wait first) is returned instead; nullptr only if nothing is waiting.
+    Trip *findNearestRequest(const City &city, const PendingRequestQueue &pending, const Driver *driver) const;
+
+    // Assign drivers to a batch of pickups so the summed cost over the whole
+    // batch is minimal, instead of letting each request take its nearest
+    // driver in arrival order. Entry i is the driver for pickups[i], or
+    // nullptr when the batch has more requests than available drivers.
+    std::vector<Driver *> assignBatch(City &city, const DriverIndex &index, const std::vector<int> &pickups);
+
+    // Calculate cost for a driver at the given road distance (-1 = unreachable)
+    int calculateCost(int distance, const Driver *driver, int pickupZone) const;
 
-    // Find the nearest available driver with the lowest cost
-    // Cost = Distance + Penalty (50 if driver's zone != pickup zone)
-    Driver *findNearestDriver(City &city, std::vector<Driver *> &drivers, const std::string &pickupLocation);
+    const CostPolicy &getCostPolicy() const;
 
 private:
-    // Calculate cost for a driver
-    int calculateCost(City &city, Driver *driver, const std::string &pickupLocation);
+    CostPolicy policy;
+
+    static bool isBetter(int cost, const Driver *driver, int bestCost, const Driver *bestDriver);
+    static bool ranksBefore(const DriverCandidate &a, const DriverCandidate &b);
 };
 
+typedef BasicDispatchEngine<ZoneDistanceCost> DispatchEngine;
+
+// The default engine is compiled once, in DispatchEngine.cpp
+extern template class BasicDispatchEngine<ZoneDistanceCost>;
+
+template <class CostPolicy>
+BasicDispatchEngine<CostPolicy>::BasicDispatchEngine(const CostPolicy &policy) : policy(policy) {}
+
+template <class CostPolicy>
+const CostPolicy &BasicDispatchEngine<CostPolicy>::getCostPolicy() const
+{
+    return policy;
+}
+
+template <class CostPolicy>
+Driver *BasicDispatchEngine<CostPolicy>::findNearestDriver(City &city, const DriverIndex &index, int pickupLocation)
+{
+    int pickupZone = city.getZone(pickupLocation);
+    if (pickupZone == -1)
+    {
+        std::cerr << "Error: Pickup location not found in city\n";
+        return nullptr;
+    }
+
+    if (index.getAvailableCount() == 0)
+    {
+        return nullptr;
+    }
+
+    Driver *bestDriver = nullptr;
+    int bestCost = INT_MAX;
+    size_t reached = 0;
+    size_t reachedInZone = 0;
+    // Counts are a snapshot; with other threads booking they only steer when to stop
+    size_t availableInZone = index.getAvailableCountInZone(pickupZone);
+    size_t located = index.getLocatedCount();
+
+    DistanceScan scan(city, pickupLocation);
+    int node;
+    int distance;
+    while (reached < located && scan.next(node, distance))
+    {
+        // Nothing further out can beat the best cost
+        if (policy.minCost(distance) > bestCost)
+        {
+            break;
+        }
+        // Past this point only in-zone drivers could still win
+        if (policy.minOutOfZoneCost(distance) > bestCost && reachedInZone >= availableInZone)
+        {
+            break;
+        }
+
+        index.forEachAvailableAt(node, [&](Driver *driver)
+        {
+            ++reached;
+            if (driver->getZoneID() == pickupZone)
+            {
+                ++reachedInZone;
+            }
+
+            int cost = calculateCost(distance, driver, pickupZone);
+            if (isBetter(cost, driver, bestCost, bestDriver))
+            {
+                bestCost = cost;
+                bestDriver = driver;
+            }
+        });
+    }
+
+    if (!bestDriver)
+    {
+        // Nobody can reach the pickup; fall back to the cheapest unreachable driver
+        for (Driver *driver : index.getAllAvailable())
+        {
+            int cost = calculateCost(-1, driver, pickupZone);
+            if (isBetter(cost, driver, bestCost, bestDriver))
+            {
+                bestCost = cost;
+                bestDriver = driver;
+            }
+        }
+    }
+
+    return bestDriver;
+}
+
+template <class CostPolicy>
+std::vector<DriverCandidate> BasicDispatchEngine<CostPolicy>::findNearestDrivers(const City &city, const DriverIndex &index,
+                                                                                 int pickupLocation, size_t k, int maxRadius) const
+{
+    std::vector<DriverCandidate> result;
+    int pickupZone = city.getZone(pickupLocation);
+    if (pickupZone == -1)
+    {
+        std::cerr << "Error: Pickup location not found in city\n";
+        return result;
+    }
+    if (k == 0 || index.getAvailableCount() == 0)
+    {
+        return result;
+    }
+
+    // Max-heap on rank: the top is the weakest of the k kept so far
+    std::priority_queue<DriverCandidate, std::vector<DriverCandidate>,
+                        bool (*)(const DriverCandidate &, const DriverCandidate &)> kept(&ranksBefore);
+    size_t reached = 0;
+    size_t reachedInZone = 0;
+    size_t availableInZone = index.getAvailableCountInZone(pickupZone);
+    size_t located = index.getLocatedCount();
+
+    DistanceScan scan(city, pickupLocation);
+    int node;
+    int distance;
+    while (reached < located && scan.next(node, distance))
+    {
+        if (distance > maxRadius)
+        {
+            break;
+        }
+        if (kept.size() == k)
+        {
+            int worstCost = kept.top().cost;
+            if (policy.minCost(distance) > worstCost)
+            {
+                break;
+            }
+            if (policy.minOutOfZoneCost(distance) > worstCost && reachedInZone >= availableInZone)
+            {
+                break;
+            }
+        }
+
+        index.forEachAvailableAt(node, [&](Driver *driver)
+        {
+            ++reached;
+            if (driver->getZoneID() == pickupZone)
+            {
+                ++reachedInZone;
+            }
+
+            DriverCandidate candidate = {driver, distance, calculateCost(distance, driver, pickupZone)};
+            if (kept.size() < k)
+            {
+                kept.push(candidate);
+            }
+            else if (ranksBefore(candidate, kept.top()))
+            {
+                kept.pop();
+                kept.push(candidate);
+            }
+        });
+    }
+
+    // Draining the heap yields the weakest first
+    result.resize(kept.size());
+    for (size_t i = result.size(); i > 0; --i)
+    {
+        result[i - 1] = kept.top();
+        kept.pop();
+    }
+    return result;
+}
+
+template <class CostPolicy>
+Trip *BasicDispatchEngine<CostPolicy>::findNearestRequest(const City &city, const PendingRequestQueue &pending,
+                                                          const Driver *driver) const
+{
+    size_t waiting = pending.size();
+    int start = driver->getCurrentLocation();
+    if (waiting == 0 || start < 0)
+    {
+        return nullptr;
+    }
+
+    Trip *bestTrip = nullptr;
+    int bestCost = INT_MAX;
+    unsigned long long bestOrder = 0;
+    size_t reached = 0;
+
+    // Roads are bidirectional, so scanning from the driver gives driver-to-pickup distances
+    DistanceScan scan(city, start);
+    int node;
+    int distance;
+    while (reached < waiting && scan.next(node, distance))
+    {
+        if (policy.minCost(distance) > bestCost)
+        {
+            break;
+        }
+
+        std::vector<PendingRequest> here = pending.getWaitingAt(node);
+        if (here.empty())
+        {
+            continue;
+        }
+        int cost = calculateCost(distance, driver, city.getZone(node));
+        for (const PendingRequest &request : here)
+        {
+            ++reached;
+            if (cost < bestCost || (cost == bestCost && request.order < bestOrder))
+            {
+                bestCost = cost;
+                bestOrder = request.order;
+                bestTrip = request.trip;
+            }
+        }
+    }
+
+    if (!bestTrip)
+    {
+        // No pickup is reachable; as findNearestDriver does, fall back to the
+        // cheapest unreachable one, longest wait first
+        for (Trip *trip : pending.getWaiting())
+        {
+            int cost = calculateCost(-1, driver, city.getZone(trip->getPickup()));
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestTrip = trip;
+            }
+        }
+    }
+
+    return bestTrip;
+}
+
+template <class CostPolicy>
+std::vector<Driver *> BasicDispatchEngine<CostPolicy>::assignBatch(City &city, const DriverIndex &index, const std::vector<int> &pickups)
+{
+    std::vector<Driver *> result(pickups.size(), nullptr);
+
+    // Snapshot of the fleet; drivers claimed meanwhile are caught by the caller's reservation
+    std::vector<Driver *> fleet = index.getAllAvailable();
+    size_t located = index.getLocatedCount();
+    if (pickups.empty() || fleet.empty())
+    {
+        return result;
+    }
+
+    struct Row
+    {
+        int request;
+        int pickup;
+        int zone;
+        size_t keep;                                // Cheapest drivers the search must find
+        bool bounded;                               // Search stopped early; unseen drivers cost >= bound
+        int bound;
+        std::vector<std::pair<Driver *, int>> seen; // Driver and exact cost
+    };
+
+    // Rows: pickups that exist in the city
+    std::vector<Row> rows;
+    for (size_t i = 0; i < pickups.size(); ++i)
+    {
+        int zone = city.getZone(pickups[i]);
+        if (zone == -1)
+        {
+            std::cerr << "Error: Pickup location not found in city\n";
+            continue;
+        }
+        Row row;
+        row.request = (int)i;
+        row.pickup = pickups[i];
+        row.zone = zone;
+        row.keep = 0;
+        row.bounded = false;
+        row.bound = 0;
+        rows.push_back(row);
+    }
+    size_t rowCount = rows.size();
+    if (rowCount == 0)
+    {
+        return result;
+    }
+
+    // Some optimal assignment gives every request one of its rowCount cheapest
+    // drivers: at most rowCount - 1 of them are taken by other requests, so a
+    // pricier pick could be swapped for a free one. Most requests need far
+    // fewer, so each search starts small. Drivers a search has not seen get
+    // the policy's minimum cost at its frontier as a lower bound, and only
+    // requests whose optimal
+    // pick lands on such a bound search again with twice the reach.
+    // Heavier than any sum of real costs (policies keep costs below INT_MAX),
+    // so it is never picked while a real option exists
+    const long long FORBIDDEN = (long long)INT_MAX * (long long)(rowCount + 1);
+    const size_t INITIAL_KEEP = 4;
+    std::vector<bool> dirty(rowCount, true);
+    for (size_t r = 0; r < rowCount; ++r)
+    {
+        rows[r].keep = std::min(rowCount, INITIAL_KEEP);
+    }
+    bool allDrivers = false;
+
+    while (true)
+    {
+        // Rescan the requests that need more reach; searches are independent
+        std::vector<size_t> rescan;
+        for (size_t r = 0; r < rowCount; ++r)
+        {
+            if (dirty[r])
+            {
+                rescan.push_back(r);
+                dirty[r] = false;
+            }
+        }
+        ThreadPool::shared().parallelFor(0, rescan.size(), 1, [&](size_t low, size_t high)
+        {
+            for (size_t u = low; u < high; ++u)
+            {
+                Row &row = rows[rescan[u]];
+                row.seen.clear();
+                row.bounded = false;
+                std::priority_queue<int> cheapest; // Max-heap of the best `keep` costs so far
+                size_t reached = 0;
+
+                DistanceScan scan(city, row.pickup);
+                int node;
+                int distance;
+                while (reached < located && scan.next(node, distance))
+                {
+                    // Nothing from here on beats the kept costs
+                    if (cheapest.size() == row.keep && policy.minCost(distance) > cheapest.top())
+                    {
+                        row.bounded = true;
+                        row.bound = policy.minCost(distance);
+                        break;
+                    }
+                    index.forEachAvailableAt(node, [&](Driver *driver)
+                    {
+                        ++reached;
+                        int cost = calculateCost(distance, driver, row.zone);
+                        if (cheapest.size() < row.keep)
+                        {
+                            cheapest.push(cost);
+                        }
+                        else if (cost < cheapest.top())
+                        {
+                            cheapest.pop();
+                            cheapest.push(cost);
+                        }
+                        row.seen.push_back(std::make_pair(driver, cost));
+                    });
+                }
+            }
+        });
+
+        // Columns: drivers some search reached, or the whole fleet once needed
+        std::vector<Driver *> candidates;
+        std::unordered_map<const Driver *, int> column;
+        for (size_t r = 0; r < rowCount; ++r)
+        {
+            for (size_t i = 0; i < rows[r].seen.size(); ++i)
+            {
+                Driver *driver = rows[r].seen[i].first;
+                if (column.insert(std::make_pair(driver, (int)candidates.size())).second)
+                {
+                    candidates.push_back(driver);
+                }
+            }
+        }
+        size_t unseen = 0;
+        for (Driver *driver : fleet)
+        {
+            if (column.find(driver) != column.end())
+            {
+                continue;
+            }
+            if (allDrivers)
+            {
+                column[driver] = (int)candidates.size();
+                candidates.push_back(driver);
+            }
+            else
+            {
+                ++unseen;
+            }
+        }
+
+        // Placeholder columns stand in for drivers nobody has reached yet
+        int realCols = (int)candidates.size();
+        int placeholders = (int)std::min(rowCount, unseen);
+        int cols = realCols + placeholders;
+
+        std::vector<long long> cost(rowCount * cols);
+        std::vector<bool> estimated(rowCount * cols, false);
+        for (size_t r = 0; r < rowCount; ++r)
+        {
+            const Row &row = rows[r];
+            long long *rowCost = &cost[r * cols];
+            for (int col = 0; col < cols; ++col)
+            {
+                if (row.bounded && row.keep == rowCount)
+                {
+                    rowCost[col] = FORBIDDEN; // Swap argument: the seen drivers suffice
+                }
+                else if (row.bounded)
+                {
+                    rowCost[col] = row.bound;
+                    estimated[r * cols + col] = true;
+                }
+                else if (col < realCols)
+                {
+                    rowCost[col] = calculateCost(-1, candidates[col], row.zone); // Truly unreachable
+                }
+                else
+                {
+                    rowCost[col] = policy.minCost(-1); // Unreachable, exact cost still unknown
+                    estimated[r * cols + col] = true;
+                }
+            }
+            for (size_t i = 0; i < row.seen.size(); ++i)
+            {
+                int col = column[row.seen[i].first];
+                rowCost[col] = row.seen[i].second;
+                estimated[r * cols + col] = false;
+            }
+        }
+
+        // Minimise the summed cost over the whole batch
+        std::vector<int> assignment = solveAssignment(cost, (int)rowCount, cols);
+
+        bool settled = true;
+        for (size_t r = 0; r < rowCount; ++r)
+        {
+            int col = assignment[r];
+            if (col == -1 || !estimated[r * cols + col])
+            {
+                continue;
+            }
+            settled = false;
+            if (rows[r].bounded)
+            {
+                rows[r].keep = std::min(rowCount, rows[r].keep * 2);
+                dirty[r] = true;
+            }
+            else
+            {
+                allDrivers = true; // Only unreachable drivers are left for this request
+            }
+        }
+
+        if (settled)
+        {
+            for (size_t r = 0; r < rowCount; ++r)
+            {
+                if (assignment[r] != -1)
+                {
+                    result[rows[r].request] = candidates[assignment[r]];
+                }
+            }
+            return result;
+        }
+    }
+}
+
+template <class CostPolicy>
+bool BasicDispatchEngine<CostPolicy>::isBetter(int cost, const Driver *driver, int bestCost, const Driver *bestDriver)
+{
+    // Ties go to the earlier-registered driver, matching a scan over the fleet
+    return cost < bestCost || (cost == bestCost && bestDriver && driver->getId() < bestDriver->getId());
+}
+
+template <class CostPolicy>
+bool BasicDispatchEngine<CostPolicy>::ranksBefore(const DriverCandidate &a, const DriverCandidate &b)
+{
+    return isBetter(a.cost, a.driver, b.cost, b.driver);
+}
+
+template <class CostPolicy>
+int BasicDispatchEngine<CostPolicy>::calculateCost(int distance, const Driver *driver, int pickupZone) const
+{
+    return policy.cost(distance, driver, pickupZone);
+}
+
 #endif // DISPATCHENGINE_H
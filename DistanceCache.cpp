@@ -0,0 +1,153 @@
+#include "DistanceCache.h"
+
+namespace
+{
+// Slot plus hash node and bucket overhead, used to turn a byte budget into entries
+const size_t BYTES_PER_ENTRY = 64;
+} // namespace
+
+DistanceCache::DistanceCache(size_t capacity)
+    : capacity(capacity), hand(0), version(0), hits(0), misses(0) {}
+
+unsigned long long DistanceCache::makeKey(int nodeA, int nodeB)
+{
+    if (nodeA > nodeB)
+    {
+        int swap = nodeA;
+        nodeA = nodeB;
+        nodeB = swap;
+    }
+    return ((unsigned long long)(unsigned int)nodeA << 32) | (unsigned int)nodeB;
+}
+
+void DistanceCache::syncVersion(unsigned long graphVersion)
+{
+    if (graphVersion != version)
+    {
+        clearSlots();
+        version = graphVersion;
+    }
+}
+
+void DistanceCache::resize(size_t entries)
+{
+    capacity = entries;
+    if (slots.size() > capacity)
+    {
+        clearSlots();
+    }
+}
+
+void DistanceCache::clearSlots()
+{
+    slots.clear();
+    slotOf.clear();
+    hand = 0;
+}
+
+void DistanceCache::setCapacity(size_t entries)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    resize(entries);
+}
+
+void DistanceCache::setMemoryLimit(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    resize(bytes / BYTES_PER_ENTRY);
+}
+
+bool DistanceCache::lookup(int nodeA, int nodeB, unsigned long graphVersion, int &distance)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    syncVersion(graphVersion);
+
+    std::unordered_map<unsigned long long, size_t>::const_iterator found = slotOf.find(makeKey(nodeA, nodeB));
+    if (found == slotOf.end())
+    {
+        ++misses;
+        return false;
+    }
+
+    Slot &slot = slots[found->second];
+    slot.referenced = true;
+    distance = slot.distance;
+    ++hits;
+    return true;
+}
+
+void DistanceCache::store(int nodeA, int nodeB, unsigned long graphVersion, int distance)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity == 0)
+    {
+        return;
+    }
+    syncVersion(graphVersion);
+
+    unsigned long long key = makeKey(nodeA, nodeB);
+    if (slotOf.find(key) != slotOf.end())
+    {
+        return;
+    }
+
+    Slot slot;
+    slot.key = key;
+    slot.distance = distance;
+    slot.referenced = false;
+
+    if (slots.size() < capacity)
+    {
+        slotOf[key] = slots.size();
+        slots.push_back(slot);
+        return;
+    }
+
+    // CLOCK sweep: give referenced slots a second chance, evict the first cold one
+    while (slots[hand].referenced)
+    {
+        slots[hand].referenced = false;
+        hand = (hand + 1) % slots.size();
+    }
+
+    slotOf.erase(slots[hand].key);
+    slots[hand] = slot;
+    slotOf[key] = hand;
+    hand = (hand + 1) % slots.size();
+}
+
+void DistanceCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    clearSlots();
+}
+
+size_t DistanceCache::getHits() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+size_t DistanceCache::getMisses() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+size_t DistanceCache::getSize() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return slots.size();
+}
+
+size_t DistanceCache::getCapacity() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity;
+}
+
+size_t DistanceCache::getMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity * BYTES_PER_ENTRY;
+}
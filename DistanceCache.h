@@ -0,0 +1,59 @@
+#ifndef DISTANCECACHE_H
+#define DISTANCECACHE_H
+
+#include <vector>
+#include <cstddef>
+#include <unordered_map>
+#include <mutex>
+
+// Bounded cache of shortest-path distances keyed by node-ID pairs.
+// Eviction uses the CLOCK algorithm (an LRU approximation with one
+// reference bit per slot). Entries are tagged with the graph version they
+// were computed for, and the whole cache is dropped when the version moves.
+// Every member takes the cache's lock, so queries may share it across threads.
+class DistanceCache
+{
+private:
+    struct Slot
+    {
+        unsigned long long key;
+        int distance;
+        bool referenced;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<Slot> slots;
+    std::unordered_map<unsigned long long, size_t> slotOf;
+    size_t capacity;
+    size_t hand;
+    unsigned long version;
+    size_t hits;
+    size_t misses;
+
+    static unsigned long long makeKey(int nodeA, int nodeB);
+    void syncVersion(unsigned long graphVersion);
+    void resize(size_t entries);
+    void clearSlots();
+
+public:
+    explicit DistanceCache(size_t capacity);
+
+    // Maximum number of cached pairs; 0 disables caching
+    void setCapacity(size_t entries);
+    // Cap the cache by approximate memory use instead of entry count
+    void setMemoryLimit(size_t bytes);
+
+    // Look up a pair; roads are bidirectional, so (a, b) and (b, a) share an entry
+    bool lookup(int nodeA, int nodeB, unsigned long graphVersion, int &distance);
+    void store(int nodeA, int nodeB, unsigned long graphVersion, int distance);
+    void clear();
+
+    size_t getHits() const;
+    size_t getMisses() const;
+    size_t getSize() const;
+    size_t getCapacity() const;
+    // Approximate bytes held by a full cache
+    size_t getMemoryUsage() const;
+};
+
+#endif // DISTANCECACHE_H
@@ -0,0 +1,45 @@
+#include "DistanceScan.h"
+#include "City.h"
+#include <climits>
+
+DistanceScan::DistanceScan(const City &city, int source)
+    : city(city), search(city.nodes.size())
+{
+    city.freeze();
+
+    if (source >= 0 && source < (int)city.nodes.size())
+    {
+        search->setDistance(source, 0);
+        search->frontier().pushOrDecrease(source, 0);
+    }
+}
+
+bool DistanceScan::next(int &node, int &distance)
+{
+    IndexedHeap &frontier = search->frontier();
+    if (frontier.empty())
+    {
+        return false;
+    }
+
+    distance = frontier.topKey();
+    node = frontier.pop();
+
+    for (int e = city.edgeOffsets[node]; e < city.edgeOffsets[node + 1]; ++e)
+    {
+        int neighbor = city.edgeTargets[e];
+        int candidate = distance + city.edgeWeights[e];
+        if (candidate < search->getDistance(neighbor))
+        {
+            search->setDistance(neighbor, candidate);
+            frontier.pushOrDecrease(neighbor, candidate);
+        }
+    }
+
+    return true;
+}
+
+int DistanceScan::frontierDistance() const
+{
+    return search->frontier().empty() ? INT_MAX : search->frontier().topKey();
+}
@@ -0,0 +1,32 @@
+#ifndef DISTANCESCAN_H
+#define DISTANCESCAN_H
+
+#include <vector>
+#include "SearchWorkspace.h"
+
+class City;
+
+// Incremental one-to-many Dijkstra.
+// Each call to next() settles one more node in increasing distance order,
+// so callers can stop as soon as they have seen enough of the graph.
+// Roads are bidirectional, so distances from the source also equal
+// distances to the source.
+// The scan borrows a per-thread SearchWorkspace, so it must be used on the
+// thread that created it.
+class DistanceScan
+{
+private:
+    const City &city;
+    SearchWorkspace::Lease search; // Held for the scan's lifetime
+
+public:
+    DistanceScan(const City &city, int source);
+
+    // Settle the next closest node; returns false once the reachable graph is exhausted
+    bool next(int &node, int &distance);
+
+    // Distance of the next node that would be settled, INT_MAX if none remain
+    int frontierDistance() const;
+};
+
+#endif // DISTANCESCAN_H
@@ -1,9 +1,7 @@
 #include "Driver.h"
+#include "DriverStore.h"
 
-Driver::Driver(int id, const std::string &name, const std::string &carModel,
-               const std::string &numberPlate, const std::string &location, int zoneID)
-    : id(id), name(name), carModel(carModel), numberPlate(numberPlate),
-      currentLocation(location), zoneID(zoneID), isAvailable(true) {}
+Driver::Driver() : store(nullptr), id(-1) {}
 
 int Driver::getId() const
 {
@@ -12,45 +10,50 @@ int Driver::getId() const
 
 const std::string &Driver::getName() const
 {
-    return name;
+    return store->getName(id);
 }
 
 const std::string &Driver::getCarModel() const
 {
-    return carModel;
+    return store->getCarModel(id);
 }
 
 const std::string &Driver::getNumberPlate() const
 {
-    return numberPlate;
+    return store->getNumberPlate(id);
 }
 
-const std::string &Driver::getCurrentLocation() const
+int Driver::getCurrentLocation() const
 {
-    return currentLocation;
+    return store->getLocation(id);
 }
 
 int Driver::getZoneID() const
 {
-    return zoneID;
+    return store->getZone(id);
 }
 
 bool Driver::getIsAvailable() const
 {
-    return isAvailable;
+    return store->isAvailable(id);
 }
 
-void Driver::setCurrentLocation(const std::string &location)
+void Driver::setCurrentLocation(int location)
 {
-    currentLocation = location;
+    store->setLocation(id, location);
 }
 
 void Driver::setZoneID(int zone)
 {
-    zoneID = zone;
+    store->setZone(id, zone);
 }
 
 void Driver::setAvailable(bool available)
 {
-    isAvailable = available;
+    store->setAvailable(id, available);
+}
+
+bool Driver::tryReserve()
+{
+    return store->tryReserve(id);
 }
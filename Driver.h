@@ -3,32 +3,37 @@
 
 #include <string>
 
+class DriverStore;
+
+// Handle to one driver in a DriverStore, which holds the actual fields.
+// Handles never move, so Driver pointers stay valid for the store's lifetime.
 class Driver
 {
 private:
+    friend class DriverStore;
+
+    DriverStore *store;
     int id;
-    std::string name;
-    std::string carModel;
-    std::string numberPlate;
-    std::string currentLocation;
-    int zoneID;
-    bool isAvailable;
 
-public:
-    Driver(int id, const std::string &name, const std::string &carModel,
-           const std::string &numberPlate, const std::string &location, int zoneID);
+    Driver();
+    Driver(const Driver &);
+    Driver &operator=(const Driver &);
 
+public:
     int getId() const;
     const std::string &getName() const;
     const std::string &getCarModel() const;
     const std::string &getNumberPlate() const;
-    const std::string &getCurrentLocation() const;
+    int getCurrentLocation() const;
     int getZoneID() const;
     bool getIsAvailable() const;
 
-    void setCurrentLocation(const std::string &location);
+    void setCurrentLocation(int location);
     void setZoneID(int zone);
     void setAvailable(bool available);
+
+    // Atomically claim an available driver; false if someone else got there first
+    bool tryReserve();
 };
 
 #endif // DRIVER_H
@@ -0,0 +1,215 @@
+#include "DriverIndex.h"
+#include "Driver.h"
+#include "DriverStore.h"
+
+DriverIndex::DriverIndex(DriverStore &store)
+    : store(store), countBlocks(new std::atomic<CountBlock *>[MAX_COUNT_BLOCKS]), availableCount(0), locatedCount(0)
+{
+    for (size_t block = 0; block < MAX_COUNT_BLOCKS; ++block)
+    {
+        countBlocks[block].store(nullptr, std::memory_order_relaxed);
+    }
+    store.setIndex(this);
+    for (Driver *driver : store.getAvailable())
+    {
+        add(driver);
+    }
+}
+
+DriverIndex::~DriverIndex()
+{
+    store.setIndex(nullptr);
+    for (size_t block = 0; block < MAX_COUNT_BLOCKS; ++block)
+    {
+        delete countBlocks[block].load(std::memory_order_relaxed);
+    }
+}
+
+void DriverIndex::adjustCount(int node, int delta)
+{
+    size_t block = (size_t)node / COUNT_BLOCK_SIZE;
+    if (block >= MAX_COUNT_BLOCKS)
+    {
+        return; // Not counted; hasAvailableAt() sends lookups to the buckets
+    }
+    CountBlock *counts = countBlocks[block].load(std::memory_order_relaxed);
+    if (!counts)
+    {
+        counts = new CountBlock();
+        for (size_t i = 0; i < COUNT_BLOCK_SIZE; ++i)
+        {
+            counts->counts[i].store(0, std::memory_order_relaxed);
+        }
+        countBlocks[block].store(counts, std::memory_order_release);
+    }
+    counts->counts[node % COUNT_BLOCK_SIZE].fetch_add(delta, std::memory_order_relaxed);
+}
+
+size_t DriverIndex::zoneBucket(int zone)
+{
+    // Bucket 0 collects drivers without a valid zone
+    return zone < 0 ? 0 : (size_t)zone + 1;
+}
+
+void DriverIndex::insert(Driver *driver)
+{
+    int id = driver->getId();
+    int location = driver->getCurrentLocation();
+    if (location >= 0)
+    {
+        if ((size_t)location >= byNode.size())
+        {
+            byNode.resize(location + 1);
+        }
+        nodeSlot[id] = (int)byNode[location].size();
+        byNode[location].push_back(driver);
+        adjustCount(location, 1);
+        ++locatedCount;
+    }
+    placedNode[id] = location;
+
+    size_t zone = zoneBucket(driver->getZoneID());
+    if (zone >= zoneCounts.size())
+    {
+        zoneCounts.resize(zone + 1, 0);
+    }
+    ++zoneCounts[zone];
+    placedZone[id] = zone;
+
+    filed[id] = 1;
+    ++availableCount;
+}
+
+void DriverIndex::remove(Driver *driver)
+{
+    int id = driver->getId();
+    if (!filed[id])
+    {
+        return;
+    }
+
+    int slot = nodeSlot[id];
+    if (slot != -1)
+    {
+        // Swap-remove keeps removal O(1); order inside a bucket does not matter
+        std::vector<Driver *> &entries = byNode[placedNode[id]];
+        Driver *moved = entries.back();
+        entries[slot] = moved;
+        nodeSlot[moved->getId()] = slot;
+        entries.pop_back();
+        adjustCount(placedNode[id], -1);
+        nodeSlot[id] = -1;
+        --locatedCount;
+    }
+    --zoneCounts[placedZone[id]];
+
+    filed[id] = 0;
+    --availableCount;
+}
+
+void DriverIndex::add(Driver *driver)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t id = (size_t)driver->getId();
+    if (id >= filed.size())
+    {
+        nodeSlot.resize(id + 1, -1);
+        placedNode.resize(id + 1, -1);
+        placedZone.resize(id + 1, 0);
+        filed.resize(id + 1, 0);
+    }
+
+    if (driver->getIsAvailable() && !filed[id])
+    {
+        insert(driver);
+    }
+}
+
+void DriverIndex::refresh(Driver *driver)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    refreshLocked(driver);
+}
+
+void DriverIndex::refresh(const std::vector<Driver *> &drivers)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Driver *driver : drivers)
+    {
+        refreshLocked(driver);
+    }
+}
+
+void DriverIndex::refreshLocked(Driver *driver)
+{
+    // Read the driver's current fields under the lock: whichever refresh
+    // runs last sees every change made before it, so racing setters still
+    // leave the driver filed where it really is
+    int id = driver->getId();
+    if ((size_t)id >= filed.size())
+    {
+        return; // Changed before the store handed it to add()
+    }
+    bool available = driver->getIsAvailable();
+    if (filed[id] && available && placedNode[id] == driver->getCurrentLocation() &&
+        placedZone[id] == zoneBucket(driver->getZoneID()))
+    {
+        return;
+    }
+
+    remove(driver);
+    if (available)
+    {
+        insert(driver);
+    }
+}
+
+std::vector<Driver *> DriverIndex::getAvailableAt(int node) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (node < 0 || node >= (int)byNode.size())
+    {
+        return std::vector<Driver *>();
+    }
+    return byNode[node];
+}
+
+bool DriverIndex::hasAvailableAt(int node) const
+{
+    if (node < 0)
+    {
+        return false;
+    }
+    size_t block = (size_t)node / COUNT_BLOCK_SIZE;
+    if (block >= MAX_COUNT_BLOCKS)
+    {
+        return true;
+    }
+    CountBlock *counts = countBlocks[block].load(std::memory_order_acquire);
+    return counts && counts->counts[node % COUNT_BLOCK_SIZE].load(std::memory_order_relaxed) > 0;
+}
+
+std::vector<Driver *> DriverIndex::getAllAvailable() const
+{
+    return store.getAvailable();
+}
+
+size_t DriverIndex::getAvailableCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return availableCount;
+}
+
+size_t DriverIndex::getAvailableCountInZone(int zone) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bucket = zoneBucket(zone);
+    return bucket < zoneCounts.size() ? zoneCounts[bucket] : 0;
+}
+
+size_t DriverIndex::getLocatedCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return locatedCount;
+}
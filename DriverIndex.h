@@ -0,0 +1,109 @@
+#ifndef DRIVERINDEX_H
+#define DRIVERINDEX_H
+
+#include <vector>
+#include <cstddef>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+class Driver;
+class DriverStore;
+
+// Buckets of currently available drivers by City node, plus per-zone counts,
+// over a DriverStore. The store reports every availability, location and
+// zone change, so dispatch can look up the drivers standing at a node
+// directly instead of scanning the whole fleet; fleet-wide lookups scan the
+// store's availability bitset.
+// All members lock internally, so drivers may change from any thread while
+// dispatch reads; lookups return copies that stay valid after the lock is
+// released. Searches that settle many empty nodes should use
+// forEachAvailableAt(), which skips them without locking.
+class DriverIndex
+{
+private:
+    DriverStore &store;
+    mutable std::mutex mutex;
+    std::vector<std::vector<Driver *>> byNode;
+    // Available drivers per node, readable without the mutex. Blocks are
+    // allocated under it on first use and kept until destruction.
+    static const size_t COUNT_BLOCK_SIZE = 1024;
+    static const size_t MAX_COUNT_BLOCKS = 4096;
+    struct CountBlock
+    {
+        std::atomic<int> counts[COUNT_BLOCK_SIZE];
+    };
+    std::unique_ptr<std::atomic<CountBlock *>[]> countBlocks;
+    std::vector<size_t> zoneCounts; // By zone bucket
+    // Driver ID -> position inside its node bucket, -1 if absent
+    std::vector<int> nodeSlot;
+    // Driver ID -> node / zone bucket it was filed under, so a refresh can
+    // find it however its fields changed in the meantime
+    std::vector<int> placedNode;
+    std::vector<size_t> placedZone;
+    std::vector<char> filed;
+    size_t availableCount;
+    size_t locatedCount; // Available drivers standing on a valid node
+
+    DriverIndex(const DriverIndex &);
+    DriverIndex &operator=(const DriverIndex &);
+
+    static size_t zoneBucket(int zone);
+
+    void adjustCount(int node, int delta);
+    void insert(Driver *driver);
+    void remove(Driver *driver);
+    // refresh() body; the caller holds the mutex
+    void refreshLocked(Driver *driver);
+
+public:
+    // Index every driver in the store and follow its changes from then on
+    explicit DriverIndex(DriverStore &store);
+    ~DriverIndex();
+
+    // Start tracking a driver (called by the store when one is added)
+    void add(Driver *driver);
+
+    // Re-file a driver after its availability, location or zone changed
+    void refresh(Driver *driver);
+    // Re-file many drivers under one lock
+    void refresh(const std::vector<Driver *> &drivers);
+
+    // Available drivers at a node
+    std::vector<Driver *> getAvailableAt(int node) const;
+    // Whether any available driver stands at the node, without locking;
+    // like the other counts it may lag a change made on another thread
+    bool hasAvailableAt(int node) const;
+    // Call visit(Driver *) for each available driver at the node while the
+    // index is locked, so visit must not change drivers; nodes without
+    // drivers return at once
+    template <class Visitor>
+    void forEachAvailableAt(int node, Visitor visit) const;
+
+    // Every available driver, in ID order
+    std::vector<Driver *> getAllAvailable() const;
+
+    size_t getAvailableCount() const;
+    size_t getAvailableCountInZone(int zone) const;
+    size_t getLocatedCount() const;
+};
+
+template <class Visitor>
+void DriverIndex::forEachAvailableAt(int node, Visitor visit) const
+{
+    if (!hasAvailableAt(node))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (node >= (int)byNode.size())
+    {
+        return;
+    }
+    for (Driver *driver : byNode[node])
+    {
+        visit(driver);
+    }
+}
+
+#endif // DRIVERINDEX_H
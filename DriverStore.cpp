@@ -0,0 +1,282 @@
+#include "DriverStore.h"
+#include "DriverIndex.h"
+#include <iostream>
+
+namespace
+{
+int countBits(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#else
+    int bits = 0;
+    for (; word; word &= word - 1)
+    {
+        ++bits;
+    }
+    return bits;
+#endif
+}
+
+int lowestBit(std::uint64_t word)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    while (!(word & 1))
+    {
+        word >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+} // namespace
+
+DriverStore::DriverStore() : hot(MAX_BLOCKS), cold(MAX_BLOCKS), count(0), index(nullptr) {}
+
+DriverStore::HotBlock &DriverStore::hotBlock(int id) const
+{
+    return *hot[id / BLOCK_SIZE];
+}
+
+std::atomic<std::uint64_t> &DriverStore::availableWord(int id) const
+{
+    return hotBlock(id).available[(id % BLOCK_SIZE) / 64];
+}
+
+void DriverStore::notify(int id)
+{
+    DriverIndex *driverIndex = index.load();
+    if (driverIndex)
+    {
+        driverIndex->refresh(get(id));
+    }
+}
+
+Driver *DriverStore::add(const std::string &name, const std::string &carModel,
+                         const std::string &numberPlate, int location, int zoneID)
+{
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(addMutex);
+        id = count.load(std::memory_order_relaxed);
+        int block = id / BLOCK_SIZE;
+        if (block >= MAX_BLOCKS)
+        {
+            std::cerr << "Error: Driver store is full\n";
+            return nullptr;
+        }
+        if (!hot[block])
+        {
+            hot[block].reset(new HotBlock());
+            cold[block].reset(new ColdBlock());
+            for (int w = 0; w < WORDS_PER_BLOCK; ++w)
+            {
+                hot[block]->available[w].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        int slot = id % BLOCK_SIZE;
+        HotBlock &fields = *hot[block];
+        ColdBlock &details = *cold[block];
+        fields.locations[slot].store(location, std::memory_order_relaxed);
+        fields.zones[slot].store(zoneID, std::memory_order_relaxed);
+        details.names[slot] = name;
+        details.carModels[slot] = carModel;
+        details.numberPlates[slot] = numberPlate;
+        details.handles[slot].store = this;
+        details.handles[slot].id = id;
+
+        // Publish, then mark available: a scan that sees the bit also sees the driver
+        count.store(id + 1, std::memory_order_release);
+        fields.available[slot / 64].fetch_or(std::uint64_t(1) << (slot % 64));
+    }
+
+    DriverIndex *driverIndex = index.load();
+    if (driverIndex)
+    {
+        driverIndex->add(get(id));
+    }
+    return get(id);
+}
+
+size_t DriverStore::size() const
+{
+    return (size_t)count.load(std::memory_order_acquire);
+}
+
+Driver *DriverStore::get(int id) const
+{
+    if (id < 0 || id >= count.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+    return &cold[id / BLOCK_SIZE]->handles[id % BLOCK_SIZE];
+}
+
+int DriverStore::getLocation(int id) const
+{
+    return hotBlock(id).locations[id % BLOCK_SIZE];
+}
+
+int DriverStore::getZone(int id) const
+{
+    return hotBlock(id).zones[id % BLOCK_SIZE];
+}
+
+bool DriverStore::isAvailable(int id) const
+{
+    return (availableWord(id).load() >> (id % 64)) & 1;
+}
+
+const std::string &DriverStore::getName(int id) const
+{
+    return cold[id / BLOCK_SIZE]->names[id % BLOCK_SIZE];
+}
+
+const std::string &DriverStore::getCarModel(int id) const
+{
+    return cold[id / BLOCK_SIZE]->carModels[id % BLOCK_SIZE];
+}
+
+const std::string &DriverStore::getNumberPlate(int id) const
+{
+    return cold[id / BLOCK_SIZE]->numberPlates[id % BLOCK_SIZE];
+}
+
+void DriverStore::setLocation(int id, int location)
+{
+    if (hotBlock(id).locations[id % BLOCK_SIZE].exchange(location) != location)
+    {
+        notify(id);
+    }
+}
+
+void DriverStore::setZone(int id, int zone)
+{
+    if (hotBlock(id).zones[id % BLOCK_SIZE].exchange(zone) != zone)
+    {
+        notify(id);
+    }
+}
+
+void DriverStore::setAvailable(int id, bool available)
+{
+    std::uint64_t bit = std::uint64_t(1) << (id % 64);
+    std::uint64_t old = available ? availableWord(id).fetch_or(bit) : availableWord(id).fetch_and(~bit);
+    if (((old & bit) != 0) != available)
+    {
+        notify(id);
+    }
+}
+
+bool DriverStore::tryReserve(int id)
+{
+    std::uint64_t bit = std::uint64_t(1) << (id % 64);
+    if (!(availableWord(id).fetch_and(~bit) & bit))
+    {
+        return false;
+    }
+    notify(id);
+    return true;
+}
+
+size_t DriverStore::moveDrivers(const std::vector<DriverMove> &moves)
+{
+    std::vector<Driver *> moved;
+    moved.reserve(moves.size());
+    for (const DriverMove &move : moves)
+    {
+        HotBlock &block = hotBlock(move.driverId);
+        int slot = move.driverId % BLOCK_SIZE;
+        // Both swaps always run, so the zone follows the node it belongs to
+        bool newLocation = block.locations[slot].exchange(move.location) != move.location;
+        bool newZone = block.zones[slot].exchange(move.zone) != move.zone;
+        if (newLocation || newZone)
+        {
+            moved.push_back(get(move.driverId));
+        }
+    }
+
+    DriverIndex *driverIndex = index.load();
+    if (driverIndex && !moved.empty())
+    {
+        driverIndex->refresh(moved);
+    }
+    return moved.size();
+}
+
+size_t DriverStore::getAvailableCount() const
+{
+    int drivers = count.load(std::memory_order_acquire);
+    int words = (drivers + 63) / 64;
+    size_t total = 0;
+    for (int w = 0; w < words; ++w)
+    {
+        // Bits past the last driver are never set, so whole words can be counted
+        total += countBits(hot[w / WORDS_PER_BLOCK]->available[w % WORDS_PER_BLOCK].load());
+    }
+    return total;
+}
+
+std::vector<Driver *> DriverStore::getAvailable() const
+{
+    int drivers = count.load(std::memory_order_acquire);
+    int words = (drivers + 63) / 64;
+    std::vector<Driver *> result;
+    for (int w = 0; w < words; ++w)
+    {
+        ColdBlock &details = *cold[w / WORDS_PER_BLOCK];
+        int base = (w % WORDS_PER_BLOCK) * 64;
+        for (std::uint64_t bits = hot[w / WORDS_PER_BLOCK]->available[w % WORDS_PER_BLOCK].load(); bits; bits &= bits - 1)
+        {
+            result.push_back(&details.handles[base + lowestBit(bits)]);
+        }
+    }
+    return result;
+}
+
+Driver *DriverStore::getNthAvailable(size_t n) const
+{
+    int drivers = count.load(std::memory_order_acquire);
+    int words = (drivers + 63) / 64;
+    for (int w = 0; w < words; ++w)
+    {
+        std::uint64_t bits = hot[w / WORDS_PER_BLOCK]->available[w % WORDS_PER_BLOCK].load();
+        size_t inWord = (size_t)countBits(bits);
+        if (n >= inWord)
+        {
+            n -= inWord; // Skip the whole word
+            continue;
+        }
+        for (; n > 0; --n)
+        {
+            bits &= bits - 1;
+        }
+        return get(w * 64 + lowestBit(bits));
+    }
+    return nullptr;
+}
+
+PoolStats DriverStore::getMemoryStats() const
+{
+    size_t drivers = size();
+    size_t blocks = (drivers + BLOCK_SIZE - 1) / BLOCK_SIZE; // Blocks are filled in order
+    size_t perDriver = (sizeof(HotBlock) + sizeof(ColdBlock)) / BLOCK_SIZE;
+
+    PoolStats stats;
+    stats.liveObjects = drivers;
+    stats.capacity = blocks * BLOCK_SIZE;
+    stats.slabCount = blocks;
+    stats.bytesReserved = blocks * (sizeof(HotBlock) + sizeof(ColdBlock)) +
+                          MAX_BLOCKS * (sizeof(hot[0]) + sizeof(cold[0]));
+    stats.bytesInUse = drivers * perDriver;
+    return stats;
+}
+
+void DriverStore::setIndex(DriverIndex *driverIndex)
+{
+    index.store(driverIndex);
+}
@@ -0,0 +1,114 @@
+#ifndef DRIVERSTORE_H
+#define DRIVERSTORE_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include "Driver.h"
+#include "ObjectPool.h"
+
+class DriverIndex;
+
+// New location for one driver, for batched moves
+struct DriverMove
+{
+    int driverId;
+    int location; // City node ID
+    int zone;     // The node's zone
+};
+
+// Structure-of-arrays storage for the whole fleet.
+// Fields dispatch reads on every scan (location, zone, availability) sit in
+// dense per-field arrays, with availability packed one bit per driver so
+// fleet-wide passes test 64 drivers per word. Names and plates live apart,
+// so scanning never pulls them into cache. Driver objects are handles that
+// read and write through the store.
+// Drivers are kept in fixed-size blocks that never move, so handles and
+// arrays stay valid while drivers are added; every member is safe to call
+// from any thread.
+class DriverStore
+{
+public:
+    static const int BLOCK_SIZE = 1024;
+
+private:
+    static const int WORDS_PER_BLOCK = BLOCK_SIZE / 64;
+    static const int MAX_BLOCKS = 4096;
+
+    // Fields read while scanning
+    struct HotBlock
+    {
+        std::atomic<int> locations[BLOCK_SIZE]; // City node ID, -1 if unknown
+        std::atomic<int> zones[BLOCK_SIZE];
+        std::atomic<std::uint64_t> available[WORDS_PER_BLOCK];
+    };
+
+    // Fields only read for display; written once before the driver is published
+    struct ColdBlock
+    {
+        std::string names[BLOCK_SIZE];
+        std::string carModels[BLOCK_SIZE];
+        std::string numberPlates[BLOCK_SIZE];
+        Driver handles[BLOCK_SIZE];
+    };
+
+    std::vector<std::unique_ptr<HotBlock>> hot;   // MAX_BLOCKS slots, filled on demand
+    std::vector<std::unique_ptr<ColdBlock>> cold;
+    std::atomic<int> count; // Published drivers; IDs below it are readable
+    std::mutex addMutex;
+    std::atomic<DriverIndex *> index; // Told about every change, may be null
+
+    DriverStore(const DriverStore &);
+    DriverStore &operator=(const DriverStore &);
+
+    HotBlock &hotBlock(int id) const;
+    std::atomic<std::uint64_t> &availableWord(int id) const;
+    void notify(int id);
+
+public:
+    DriverStore();
+
+    // Register a new, available driver; IDs are handed out from 0 in order
+    Driver *add(const std::string &name, const std::string &carModel,
+                const std::string &numberPlate, int location, int zoneID);
+
+    size_t size() const;
+    // Handle for a driver ID, nullptr if out of range
+    Driver *get(int id) const;
+
+    int getLocation(int id) const;
+    int getZone(int id) const;
+    bool isAvailable(int id) const;
+    const std::string &getName(int id) const;
+    const std::string &getCarModel(int id) const;
+    const std::string &getNumberPlate(int id) const;
+
+    void setLocation(int id, int location);
+    void setZone(int id, int zone);
+    void setAvailable(int id, bool available);
+    // Atomically clear an available driver's bit; false if it was already clear
+    bool tryReserve(int id);
+    // Apply many location (and zone) changes in one pass and re-file the
+    // moved drivers with the index under a single lock; returns how many
+    // actually moved
+    size_t moveDrivers(const std::vector<DriverMove> &moves);
+
+    // Fleet-wide passes over the availability bitset
+    size_t getAvailableCount() const;
+    // Available drivers in ID order
+    std::vector<Driver *> getAvailable() const;
+    // The n-th available driver in ID order (0-based), nullptr if fewer
+    Driver *getNthAvailable(size_t n) const;
+
+    // Block memory held for the fleet (string contents not included)
+    PoolStats getMemoryStats() const;
+
+    // Attach the index kept in step with this store (DriverIndex does this itself)
+    void setIndex(DriverIndex *driverIndex);
+};
+
+#endif // DRIVERSTORE_H
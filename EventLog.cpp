@@ -0,0 +1,388 @@
+#include "EventLog.h"
+#include "BinaryIO.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <cstdint>
+
+using namespace binaryio;
+
+namespace
+{
+const char FILE_MAGIC[4] = {'R', 'S', 'W', 'L'};
+const int FILE_VERSION = 1;
+const size_t HEADER_SIZE = sizeof(FILE_MAGIC) + sizeof(FILE_VERSION);
+const size_t FRAME_SIZE = 2 * sizeof(std::uint32_t); // Payload length, checksum
+
+enum SegmentState
+{
+    SEGMENT_MISSING,
+    SEGMENT_BAD, // Not an event log
+    SEGMENT_READ
+};
+
+void encode(const LogEvent &event, std::vector<char> &out)
+{
+    std::vector<char> payload;
+    put<int>(payload, event.type);
+    put<int>(payload, event.tripId);
+    put<int>(payload, event.riderId);
+    put<int>(payload, event.driverId);
+    put<int>(payload, event.node);
+    put<int>(payload, event.dropoff);
+    put<int>(payload, event.zone);
+    put<long long>(payload, event.timestamp);
+    putString(payload, event.name);
+    putString(payload, event.carModel);
+    putString(payload, event.numberPlate);
+
+    put<std::uint32_t>(out, (std::uint32_t)payload.size());
+    put<std::uint32_t>(out, checksum(payload.data(), payload.size()));
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+bool decode(const char *data, size_t size, LogEvent &event)
+{
+    size_t pos = 0;
+    int type = 0;
+    bool ok = get(data, size, pos, type) &&
+              get(data, size, pos, event.tripId) &&
+              get(data, size, pos, event.riderId) &&
+              get(data, size, pos, event.driverId) &&
+              get(data, size, pos, event.node) &&
+              get(data, size, pos, event.dropoff) &&
+              get(data, size, pos, event.zone) &&
+              get(data, size, pos, event.timestamp) &&
+              getString(data, size, pos, event.name) &&
+              getString(data, size, pos, event.carModel) &&
+              getString(data, size, pos, event.numberPlate);
+    event.type = (EventType)type;
+    return ok && pos == size && type >= EVENT_DRIVER_ADDED && type <= EVENT_REQUEST_WAITING;
+}
+
+// Read one segment file, appending its intact events; valid is where the
+// first torn or damaged record starts (the file size if there is none)
+SegmentState readSegment(const std::string &path, std::vector<char> &contents,
+                         std::vector<LogEvent> &events, size_t &valid)
+{
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in)
+    {
+        return SEGMENT_MISSING;
+    }
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (contents.size() < HEADER_SIZE || std::memcmp(&contents[0], FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+    {
+        return SEGMENT_BAD;
+    }
+
+    valid = HEADER_SIZE;
+    while (contents.size() - valid >= FRAME_SIZE)
+    {
+        std::uint32_t length = 0;
+        std::uint32_t expected = 0;
+        std::memcpy(&length, &contents[valid], sizeof(length));
+        std::memcpy(&expected, &contents[valid + sizeof(length)], sizeof(expected));
+        if (contents.size() - valid - FRAME_SIZE < length)
+        {
+            break;
+        }
+        const char *payload = &contents[0] + valid + FRAME_SIZE;
+        LogEvent event;
+        if (checksum(payload, length) != expected || !decode(payload, length, event))
+        {
+            break;
+        }
+        events.push_back(event);
+        valid += FRAME_SIZE + length;
+    }
+    return SEGMENT_READ;
+}
+
+// Create (or replace) a segment holding the header and then the given records
+bool writeSegment(const std::string &path, const char *records, size_t size)
+{
+    std::vector<char> header(FILE_MAGIC, FILE_MAGIC + sizeof(FILE_MAGIC));
+    put<int>(header, FILE_VERSION);
+    std::FILE *out = std::fopen(path.c_str(), "wb");
+    bool ok = out && std::fwrite(&header[0], 1, header.size(), out) == header.size();
+    if (ok && size > 0)
+    {
+        ok = std::fwrite(records, 1, size, out) == size;
+    }
+    ok = ok && syncFile(out);
+    if (out)
+    {
+        std::fclose(out);
+    }
+    // A new segment must still be there after a crash, or the log has a gap
+    ok = ok && syncDirectoryOf(path);
+    if (!ok)
+    {
+        std::cerr << "Error: Cannot write event log " << path << "\n";
+    }
+    return ok;
+}
+
+} // namespace
+
+LogEvent::LogEvent(EventType type)
+    : type(type), tripId(-1), riderId(-1), driverId(-1), node(-1), dropoff(-1), zone(0), timestamp(0) {}
+
+EventLog::EventLog()
+    : file(nullptr), segment(0), appendedCount(0), durableCount(0), closing(false), writing(false), failed(false),
+      flushCount(0), fileBytes(0) {}
+
+EventLog::~EventLog()
+{
+    close();
+}
+
+std::string EventLog::segmentPath(const std::string &path, unsigned segment)
+{
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), ".%06u", segment);
+    return path + suffix;
+}
+
+bool EventLog::open(const std::string &path, unsigned firstSegment, std::vector<LogEvent> &existing)
+{
+    if (isOpen())
+    {
+        std::cerr << "Error: Event log is already open\n";
+        return false;
+    }
+    if (firstSegment == 0)
+    {
+        firstSegment = 1;
+    }
+
+    unsigned last = 0;
+    size_t lastBytes = HEADER_SIZE;
+    for (unsigned seq = firstSegment;; ++seq)
+    {
+        std::string segmentFile = segmentPath(path, seq);
+        std::vector<char> contents;
+        size_t valid = 0;
+        SegmentState state = readSegment(segmentFile, contents, existing, valid);
+        if (state == SEGMENT_MISSING)
+        {
+            // Segments are numbered without gaps; stopping here would drop
+            // every change logged after the missing one
+            std::ifstream next(segmentPath(path, seq + 1).c_str());
+            if (next)
+            {
+                std::cerr << "Error: " << segmentFile << " is missing from the event log\n";
+                return false;
+            }
+            break;
+        }
+        if (state == SEGMENT_BAD)
+        {
+            std::cerr << "Error: " << segmentFile << " is not an event log\n";
+            return false;
+        }
+
+        if (valid < contents.size())
+        {
+            // A crash can only tear the newest segment; anything else is damage
+            std::ifstream next(segmentPath(path, seq + 1).c_str());
+            if (next)
+            {
+                std::cerr << "Error: " << segmentFile << " is damaged before the end of the log\n";
+                return false;
+            }
+            std::cout << "[INFO] Dropping " << (contents.size() - valid)
+                      << " bytes of incomplete records from " << segmentFile << "\n";
+            if (!writeSegment(segmentFile, &contents[0] + HEADER_SIZE, valid - HEADER_SIZE))
+            {
+                return false;
+            }
+        }
+        last = seq;
+        lastBytes = valid;
+    }
+
+    if (last == 0)
+    {
+        last = firstSegment;
+        if (!writeSegment(segmentPath(path, last), nullptr, 0))
+        {
+            return false;
+        }
+    }
+
+    std::FILE *appendFile = std::fopen(segmentPath(path, last).c_str(), "ab");
+    if (!appendFile)
+    {
+        std::cerr << "Error: Cannot open event log " << segmentPath(path, last) << "\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    file = appendFile;
+    basePath = path;
+    segment = last;
+    pending.clear();
+    appendedCount = 0;
+    durableCount = 0;
+    closing = false;
+    writing = false;
+    failed = false;
+    flushCount = 0;
+    fileBytes = lastBytes;
+    flusher = std::thread(&EventLog::flushLoop, this);
+    return true;
+}
+
+unsigned EventLog::roll()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    // Whatever was appended before the roll belongs to the old segment
+    while (file && !failed && (!pending.empty() || writing))
+    {
+        flushed.wait(lock);
+    }
+    if (!file || failed)
+    {
+        return 0;
+    }
+
+    std::string next = segmentPath(basePath, segment + 1);
+    if (!writeSegment(next, nullptr, 0))
+    {
+        return 0;
+    }
+    std::FILE *nextFile = std::fopen(next.c_str(), "ab");
+    if (!nextFile)
+    {
+        std::cerr << "Error: Cannot open event log " << next << "\n";
+        return 0;
+    }
+
+    std::fclose(file);
+    file = nextFile;
+    ++segment;
+    fileBytes = HEADER_SIZE;
+    return segment;
+}
+
+void EventLog::dropSegmentsBefore(unsigned firstKept)
+{
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        path = basePath;
+    }
+    // Segments are numbered without gaps, so stop at the first one already gone
+    for (unsigned seq = firstKept; seq > 1; --seq)
+    {
+        if (std::remove(segmentPath(path, seq - 1).c_str()) != 0)
+        {
+            break;
+        }
+    }
+}
+
+void EventLog::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file)
+        {
+            return;
+        }
+        closing = true;
+    }
+    wake.notify_all();
+    flusher.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::fclose(file);
+    file = nullptr;
+    closing = false;
+    flushed.notify_all();
+}
+
+bool EventLog::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return file != nullptr;
+}
+
+void EventLog::append(const LogEvent &event)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file || failed)
+        {
+            return;
+        }
+        encode(event, pending);
+        ++appendedCount;
+    }
+    wake.notify_one();
+}
+
+bool EventLog::sync()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    unsigned long long target = appendedCount;
+    while (file && !failed && durableCount < target)
+    {
+        flushed.wait(lock);
+    }
+    return file && !failed;
+}
+
+void EventLog::flushLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        while (pending.empty() && !closing)
+        {
+            wake.wait(lock);
+        }
+        if (pending.empty())
+        {
+            return; // Closing with nothing left to write
+        }
+
+        // Everything appended while the previous flush ran goes out together
+        std::vector<char> batch;
+        batch.swap(pending);
+        unsigned long long upTo = appendedCount;
+        writing = true;
+        lock.unlock();
+
+        bool ok = std::fwrite(&batch[0], 1, batch.size(), file) == batch.size() && syncFile(file);
+
+        lock.lock();
+        writing = false;
+        if (ok)
+        {
+            durableCount = upTo;
+            fileBytes += batch.size();
+            ++flushCount;
+        }
+        else if (!failed)
+        {
+            failed = true;
+            std::cerr << "Error: Event log write failed; further events are not logged\n";
+        }
+        flushed.notify_all();
+    }
+}
+
+LogStats EventLog::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    LogStats stats;
+    stats.events = (size_t)appendedCount;
+    stats.flushes = flushCount;
+    stats.bytes = fileBytes;
+    stats.segment = segment;
+    return stats;
+}
@@ -0,0 +1,114 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// Kinds of state change the log records
+enum EventType
+{
+    EVENT_DRIVER_ADDED = 1,
+    EVENT_RIDER_ADDED,
+    EVENT_TRIP_REQUESTED,
+    EVENT_STATE_RECORDED, // A trip's state was pushed on the undo stack
+    EVENT_TRIP_ASSIGNED,
+    EVENT_TRIP_COMPLETED,
+    EVENT_TRIP_CANCELLED,
+    EVENT_UNDO,
+    EVENT_REQUEST_WAITING // A trip joined the back of the waiting queue
+};
+
+// One logged change; fields a type doesn't use stay at their defaults
+struct LogEvent
+{
+    EventType type;
+    int tripId;
+    int riderId;
+    int driverId;
+    int node;    // Driver/rider location, or trip pickup
+    int dropoff; // Trip dropoff
+    int zone;    // Driver zone
+    long long timestamp; // Request or finish time, milliseconds since the epoch
+    std::string name;
+    std::string carModel;
+    std::string numberPlate;
+
+    explicit LogEvent(EventType type = EVENT_UNDO);
+};
+
+struct LogStats
+{
+    size_t events;  // Appended since open
+    size_t flushes; // fsyncs issued for them
+    size_t bytes;   // Size of the current segment
+    unsigned segment; // Segment being appended to
+};
+
+// Append-only binary write-ahead log with group commit, kept as numbered
+// segment files (path.000001, path.000002, ...).
+// append() only encodes the event into a buffer; a background thread writes
+// whatever has built up and fsyncs once for the lot, so events from many
+// callers share each flush. sync() blocks until everything appended so far
+// is on disk. Each record carries its length and a checksum, so a record
+// torn by a crash is detected and dropped when the log is reopened.
+// roll() starts a new segment, so a snapshot taken at that point makes all
+// earlier segments redundant; dropSegmentsBefore() then deletes them.
+// All members lock internally.
+class EventLog
+{
+private:
+    mutable std::mutex mutex;
+    std::condition_variable wake;    // Flusher: events pending or closing
+    std::condition_variable flushed; // sync(): durable point moved
+    std::FILE *file;
+    std::string basePath;
+    unsigned segment; // Number of the segment being appended to
+    std::vector<char> pending; // Encoded, not yet written
+    unsigned long long appendedCount;
+    unsigned long long durableCount; // Events known to be on disk
+    bool closing;
+    bool writing; // The flusher is writing a batch outside the lock
+    bool failed; // A write or fsync failed; the log stops accepting events
+    size_t flushCount;
+    size_t fileBytes;
+    std::thread flusher;
+
+    EventLog(const EventLog &);
+    EventLog &operator=(const EventLog &);
+
+    void flushLoop();
+    static std::string segmentPath(const std::string &path, unsigned segment);
+
+public:
+    EventLog();
+    ~EventLog();
+
+    // Read the events in segments firstSegment onward (creating the first if
+    // none exist), drop a torn record at the end, and start appending after them.
+    // Fails if a segment is missing while a later one exists.
+    bool open(const std::string &path, unsigned firstSegment, std::vector<LogEvent> &existing);
+    // Flush everything and stop the flusher
+    void close();
+    bool isOpen() const;
+
+    void append(const LogEvent &event);
+    // Wait until every event appended so far is durable; false if the log
+    // failed or is closed
+    bool sync();
+
+    // Close the current segment once everything appended is written and
+    // continue in a new one; returns its number, 0 on failure.
+    // Events appended while this runs may land in either segment.
+    unsigned roll();
+    // Delete the segments numbered below firstKept
+    void dropSegmentsBefore(unsigned firstKept);
+
+    LogStats getStats() const;
+};
+
+#endif // EVENTLOG_H
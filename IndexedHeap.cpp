@@ -0,0 +1,151 @@
+#include "IndexedHeap.h"
+
+IndexedHeap::IndexedHeap() {}
+
+void IndexedHeap::resize(size_t nodeCount)
+{
+    if (position.size() < nodeCount)
+    {
+        position.resize(nodeCount, -1);
+    }
+}
+
+void IndexedHeap::clear()
+{
+    for (size_t i = 0; i < heap.size(); ++i)
+    {
+        position[heap[i].node] = -1;
+    }
+    heap.clear();
+}
+
+bool IndexedHeap::empty() const
+{
+    return heap.empty();
+}
+
+size_t IndexedHeap::size() const
+{
+    return heap.size();
+}
+
+bool IndexedHeap::contains(int node) const
+{
+    return position[node] != -1;
+}
+
+void IndexedHeap::pushOrDecrease(int node, int key)
+{
+    int slot = position[node];
+    if (slot == -1)
+    {
+        Entry entry;
+        entry.key = key;
+        entry.node = node;
+        heap.push_back(entry);
+        position[node] = (int)heap.size() - 1;
+        siftUp(heap.size() - 1);
+    }
+    else if (key < heap[slot].key)
+    {
+        heap[slot].key = key;
+        siftUp(slot);
+    }
+}
+
+void IndexedHeap::pushOrUpdate(int node, int key)
+{
+    int slot = position[node];
+    if (slot == -1 || key < heap[slot].key)
+    {
+        pushOrDecrease(node, key);
+    }
+    else if (key > heap[slot].key)
+    {
+        heap[slot].key = key;
+        siftDown(slot);
+    }
+}
+
+int IndexedHeap::topNode() const
+{
+    return heap[0].node;
+}
+
+int IndexedHeap::topKey() const
+{
+    return heap[0].key;
+}
+
+int IndexedHeap::pop()
+{
+    int node = heap[0].node;
+    position[node] = -1;
+
+    Entry last = heap.back();
+    heap.pop_back();
+
+    if (!heap.empty())
+    {
+        place(0, last);
+        siftDown(0);
+    }
+
+    return node;
+}
+
+void IndexedHeap::place(size_t slot, const Entry &entry)
+{
+    heap[slot] = entry;
+    position[entry.node] = (int)slot;
+}
+
+void IndexedHeap::siftUp(size_t slot)
+{
+    Entry entry = heap[slot];
+    while (slot > 0)
+    {
+        size_t parent = (slot - 1) / 4;
+        if (heap[parent].key <= entry.key)
+        {
+            break;
+        }
+        place(slot, heap[parent]);
+        slot = parent;
+    }
+    place(slot, entry);
+}
+
+void IndexedHeap::siftDown(size_t slot)
+{
+    Entry entry = heap[slot];
+    size_t count = heap.size();
+
+    while (true)
+    {
+        size_t firstChild = slot * 4 + 1;
+        if (firstChild >= count)
+        {
+            break;
+        }
+
+        // Pick the smallest of up to four children
+        size_t best = firstChild;
+        size_t lastChild = firstChild + 4 < count ? firstChild + 4 : count;
+        for (size_t child = firstChild + 1; child < lastChild; ++child)
+        {
+            if (heap[child].key < heap[best].key)
+            {
+                best = child;
+            }
+        }
+
+        if (heap[best].key >= entry.key)
+        {
+            break;
+        }
+        place(slot, heap[best]);
+        slot = best;
+    }
+    place(slot, entry);
+}
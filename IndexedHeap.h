@@ -0,0 +1,52 @@
+#ifndef INDEXEDHEAP_H
+#define INDEXEDHEAP_H
+
+#include <vector>
+#include <cstddef>
+
+// Indexed 4-ary min-heap keyed by node ID.
+// Each node appears at most once; decreaseKey moves it in place instead of
+// pushing a duplicate entry, so the heap never grows beyond the node count.
+class IndexedHeap
+{
+private:
+    struct Entry
+    {
+        int key;
+        int node;
+    };
+
+    std::vector<Entry> heap;
+    std::vector<int> position; // node -> slot in heap, -1 if not queued
+
+    void siftUp(size_t slot);
+    void siftDown(size_t slot);
+    void place(size_t slot, const Entry &entry);
+
+public:
+    IndexedHeap();
+
+    // Make room for node IDs in [0, nodeCount)
+    void resize(size_t nodeCount);
+
+    // Remove all queued nodes; cost is proportional to the current heap size
+    void clear();
+
+    bool empty() const;
+    size_t size() const;
+    bool contains(int node) const;
+
+    // Insert node, or lower its key if it is already queued with a larger one
+    void pushOrDecrease(int node, int key);
+
+    // Insert node, or move it to the new key in either direction
+    void pushOrUpdate(int node, int key);
+
+    int topNode() const;
+    int topKey() const;
+
+    // Remove and return the node with the smallest key
+    int pop();
+};
+
+#endif // INDEXEDHEAP_H
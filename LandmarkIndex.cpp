@@ -0,0 +1,232 @@
+#include "LandmarkIndex.h"
+#include "City.h"
+#include "DistanceScan.h"
+#include "SearchWorkspace.h"
+#include <climits>
+#include <cstdlib>
+
+namespace
+{
+// Distances from source to every node, INT_MAX when unreachable
+std::vector<int> allDistances(const City &city, int source)
+{
+    std::vector<int> result(city.getAllNodes().size(), INT_MAX);
+    DistanceScan scan(city, source);
+    int node;
+    int distance;
+    while (scan.next(node, distance))
+    {
+        result[node] = distance;
+    }
+    return result;
+}
+} // namespace
+
+LandmarkIndex::LandmarkIndex() : graphVersion(0), built(false) {}
+
+void LandmarkIndex::build(const City &city, int count)
+{
+    city.freeze();
+    int nodeCount = (int)city.nodes.size();
+
+    landmarks.clear();
+    distances.clear();
+
+    // Nodes without roads can never be on a path, so they make useless landmarks
+    std::vector<bool> candidate(nodeCount, false);
+    int seed = -1;
+    for (int node = 0; node < nodeCount; ++node)
+    {
+        candidate[node] = city.edgeOffsets[node + 1] > city.edgeOffsets[node];
+        if (candidate[node] && seed == -1)
+        {
+            seed = node;
+        }
+    }
+
+    std::vector<std::vector<int>> columns;
+    if (seed != -1 && count > 0)
+    {
+        // Farthest-point selection: each new landmark is the node farthest from
+        // every landmark chosen so far (the first one farthest from the seed).
+        // Unreachable nodes count as infinitely far, so every connected part of
+        // the network gets a landmark before any part gets a second one.
+        std::vector<int> nearest = allDistances(city, seed);
+        std::vector<bool> zoneCovered;
+
+        while ((int)landmarks.size() < count)
+        {
+            int best = -1;
+            for (int node = 0; node < nodeCount; ++node)
+            {
+                if (!candidate[node])
+                {
+                    continue;
+                }
+                if (best == -1 || nearest[node] > nearest[best])
+                {
+                    best = node;
+                }
+                else if (nearest[node] == nearest[best])
+                {
+                    // On ties, spread landmarks across zones not yet covered
+                    int zone = city.nodes[node].zoneID;
+                    int bestZone = city.nodes[best].zoneID;
+                    bool covered = zone >= 0 && zone < (int)zoneCovered.size() && zoneCovered[zone];
+                    bool bestCovered = bestZone >= 0 && bestZone < (int)zoneCovered.size() && zoneCovered[bestZone];
+                    if (bestCovered && !covered)
+                    {
+                        best = node;
+                    }
+                }
+            }
+
+            if (best == -1 || nearest[best] == 0)
+            {
+                break; // Every candidate already is a landmark
+            }
+
+            landmarks.push_back(best);
+            candidate[best] = false;
+            columns.push_back(allDistances(city, best));
+
+            int zone = city.nodes[best].zoneID;
+            if (zone >= 0)
+            {
+                if (zone >= (int)zoneCovered.size())
+                {
+                    zoneCovered.resize(zone + 1, false);
+                }
+                zoneCovered[zone] = true;
+            }
+
+            const std::vector<int> &fromLandmark = columns.back();
+            if (landmarks.size() == 1)
+            {
+                nearest = fromLandmark; // The seed itself is not a landmark
+            }
+            else
+            {
+                for (int node = 0; node < nodeCount; ++node)
+                {
+                    if (fromLandmark[node] < nearest[node])
+                    {
+                        nearest[node] = fromLandmark[node];
+                    }
+                }
+            }
+        }
+    }
+
+    // Transpose into node-major order so one query touches one contiguous row per node
+    size_t k = landmarks.size();
+    distances.resize((size_t)nodeCount * k);
+    for (size_t i = 0; i < k; ++i)
+    {
+        for (int node = 0; node < nodeCount; ++node)
+        {
+            distances[(size_t)node * k + i] = columns[i][node];
+        }
+    }
+
+    graphVersion = city.getGraphVersion();
+    built = true;
+}
+
+bool LandmarkIndex::isBuilt() const
+{
+    return built;
+}
+
+bool LandmarkIndex::isCurrent(const City &city) const
+{
+    return built && graphVersion == city.getGraphVersion();
+}
+
+const std::vector<int> &LandmarkIndex::getLandmarks() const
+{
+    return landmarks;
+}
+
+int LandmarkIndex::lowerBound(int node, int target) const
+{
+    size_t k = landmarks.size();
+    const int *fromNode = k > 0 ? &distances[(size_t)node * k] : nullptr;
+    const int *fromTarget = k > 0 ? &distances[(size_t)target * k] : nullptr;
+
+    int bound = 0;
+    for (size_t i = 0; i < k; ++i)
+    {
+        int a = fromNode[i];
+        int b = fromTarget[i];
+        if (a == INT_MAX || b == INT_MAX)
+        {
+            if (a != b)
+            {
+                return INT_MAX; // Different connected parts: target is unreachable
+            }
+            continue;
+        }
+        int difference = std::abs(a - b);
+        if (difference > bound)
+        {
+            bound = difference;
+        }
+    }
+    return bound;
+}
+
+int LandmarkIndex::query(const City &city, int startId, int endId) const
+{
+    int nodeCount = (int)city.nodes.size();
+    if (!built || startId < 0 || endId < 0 || startId >= nodeCount || endId >= nodeCount)
+    {
+        return -1;
+    }
+    if (startId == endId)
+    {
+        return 0;
+    }
+
+    int startBound = lowerBound(startId, endId);
+    if (startBound == INT_MAX)
+    {
+        return -1;
+    }
+
+    SearchWorkspace::Lease search(nodeCount);
+    IndexedHeap &frontier = search->frontier();
+
+    search->setDistance(startId, 0);
+    frontier.pushOrDecrease(startId, startBound);
+
+    while (!frontier.empty())
+    {
+        int current = frontier.pop();
+        int currentDist = search->getDistance(current);
+
+        // The landmark bound is consistent, so the target's first pop is final
+        if (current == endId)
+        {
+            return currentDist;
+        }
+
+        for (int e = city.edgeOffsets[current]; e < city.edgeOffsets[current + 1]; ++e)
+        {
+            int neighbor = city.edgeTargets[e];
+            int candidate = currentDist + city.edgeWeights[e];
+            if (candidate < search->getDistance(neighbor))
+            {
+                int bound = lowerBound(neighbor, endId);
+                if (bound == INT_MAX)
+                {
+                    continue;
+                }
+                search->setDistance(neighbor, candidate);
+                frontier.pushOrDecrease(neighbor, candidate + bound);
+            }
+        }
+    }
+
+    return -1;
+}
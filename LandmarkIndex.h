@@ -0,0 +1,43 @@
+#ifndef LANDMARKINDEX_H
+#define LANDMARKINDEX_H
+
+#include <vector>
+
+class City;
+
+// ALT routing index: A* search guided by Landmark distances and the
+// Triangle inequality. For every landmark L, |d(L, t) - d(L, v)| is a lower
+// bound on d(v, t), which steers the search towards the target. The index
+// is just k distances per node, so rebuilding it after the road network
+// changes costs k single-source searches.
+class LandmarkIndex
+{
+private:
+    std::vector<int> landmarks;
+    // Node-major distance table: distances[node * k + i] = d(landmark i, node),
+    // INT_MAX when unreachable
+    std::vector<int> distances;
+    unsigned long graphVersion; // City::getGraphVersion() when built
+    bool built;
+
+    int lowerBound(int node, int target) const;
+
+public:
+    LandmarkIndex();
+
+    // Select up to count landmarks by farthest-point selection and record
+    // their distances to every node
+    void build(const City &city, int count);
+
+    bool isBuilt() const;
+
+    // True if the index was built for the city's current network
+    bool isCurrent(const City &city) const;
+
+    const std::vector<int> &getLandmarks() const;
+
+    // A* shortest distance between two node IDs, -1 if unreachable
+    int query(const City &city, int startId, int endId) const;
+};
+
+#endif // LANDMARKINDEX_H
@@ -0,0 +1,89 @@
+#include "LocationIngest.h"
+
+LocationIngest::LocationIngest(const City &city, DriverStore &store) : city(city), store(store) {}
+
+void LocationIngest::submit(const LocationUpdate &update)
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queued.push_back(update);
+}
+
+void LocationIngest::submit(const std::vector<LocationUpdate> &updates)
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queued.insert(queued.end(), updates.begin(), updates.end());
+}
+
+size_t LocationIngest::getQueuedCount() const
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return queued.size();
+}
+
+IngestStats LocationIngest::applyTick()
+{
+    std::lock_guard<std::mutex> tickLock(tickMutex);
+
+    {
+        // Swap buffers so submitters wait only for the swap
+        std::lock_guard<std::mutex> lock(queueMutex);
+        taken.swap(queued);
+    }
+
+    IngestStats stats = {taken.size(), 0, 0, 0, 0};
+    size_t driverCount = store.size();
+    int nodeCount = (int)city.getAllNodes().size();
+    if (lastApplied.size() < driverCount)
+    {
+        lastApplied.resize(driverCount, 0);
+        hasApplied.resize(driverCount, 0);
+        newestSlot.resize(driverCount, -1);
+    }
+
+    // Keep the newest report per driver; on equal timestamps the later arrival wins
+    newest.clear();
+    for (const LocationUpdate &update : taken)
+    {
+        int id = update.driverId;
+        if (id < 0 || (size_t)id >= driverCount || update.node < 0 || update.node >= nodeCount)
+        {
+            ++stats.invalid;
+            continue;
+        }
+        if (hasApplied[id] && update.timestamp <= lastApplied[id])
+        {
+            ++stats.outOfOrder;
+            continue;
+        }
+
+        int slot = newestSlot[id];
+        if (slot == -1)
+        {
+            newestSlot[id] = (int)newest.size();
+            newest.push_back(update);
+        }
+        else if (update.timestamp >= newest[slot].timestamp)
+        {
+            newest[slot] = update;
+            ++stats.coalesced;
+        }
+        else
+        {
+            ++stats.outOfOrder;
+        }
+    }
+
+    moves.clear();
+    for (const LocationUpdate &update : newest)
+    {
+        newestSlot[update.driverId] = -1;
+        lastApplied[update.driverId] = update.timestamp;
+        hasApplied[update.driverId] = 1;
+        DriverMove move = {update.driverId, update.node, city.getZone(update.node)};
+        moves.push_back(move);
+    }
+    stats.applied = store.moveDrivers(moves);
+
+    taken.clear();
+    return stats;
+}
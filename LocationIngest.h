@@ -0,0 +1,68 @@
+#ifndef LOCATIONINGEST_H
+#define LOCATIONINGEST_H
+
+#include <vector>
+#include <cstddef>
+#include <mutex>
+#include "City.h"
+#include "DriverStore.h"
+
+// One position report from a driver's device
+struct LocationUpdate
+{
+    int driverId;
+    int node;            // City node ID
+    long long timestamp; // Device clock; only the order matters
+};
+
+// What one tick did with the updates it took
+struct IngestStats
+{
+    size_t received;
+    size_t applied;    // Drivers whose location changed
+    size_t coalesced;  // Superseded by a newer report for the same driver
+    size_t outOfOrder; // Older than a report already taken for that driver
+    size_t invalid;    // Unknown driver or node
+};
+
+// Batched driver location ingestion.
+// Devices report far more often than dispatch needs, so reports are queued
+// and applied once per tick: each driver keeps only its newest report, late
+// reports that arrive after a newer one are dropped, and the survivors are
+// written to the store and re-filed in the index in one pass.
+// submit() may be called from any thread; ticks run one at a time.
+class LocationIngest
+{
+private:
+    const City &city;
+    DriverStore &store;
+
+    mutable std::mutex queueMutex;
+    std::vector<LocationUpdate> queued;
+
+    std::mutex tickMutex;
+    // Reused between ticks so a steady stream allocates nothing
+    std::vector<LocationUpdate> taken;
+    std::vector<LocationUpdate> newest;
+    std::vector<DriverMove> moves;
+    // Driver ID -> timestamp of the last applied report
+    std::vector<long long> lastApplied;
+    std::vector<char> hasApplied;
+    // Driver ID -> position in newest during a tick, -1 if none
+    std::vector<int> newestSlot;
+
+    LocationIngest(const LocationIngest &);
+    LocationIngest &operator=(const LocationIngest &);
+
+public:
+    LocationIngest(const City &city, DriverStore &store);
+
+    void submit(const LocationUpdate &update);
+    void submit(const std::vector<LocationUpdate> &updates);
+    size_t getQueuedCount() const;
+
+    // Apply everything queued so far
+    IngestStats applyTick();
+};
+
+#endif // LOCATIONINGEST_H
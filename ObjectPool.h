@@ -0,0 +1,144 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <vector>
+#include <cstddef>
+#include <mutex>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+// Memory held by one pool or store
+struct PoolStats
+{
+    size_t liveObjects;
+    size_t capacity;      // Objects the allocated slabs can hold
+    size_t slabCount;
+    size_t bytesReserved; // Slab memory, excluding what objects allocate themselves
+    size_t bytesInUse;    // Share of bytesReserved taken by live objects
+};
+
+// Slab allocator for one entity type.
+// Objects are carved from fixed-size slabs and never move, so raw pointers
+// to them stay valid until they are destroyed. Allocation and release are
+// O(1) through a free list; destroying the pool tears down every live
+// object and frees the slabs in bulk.
+// All members lock internally.
+template <class T, size_t SlabSize = 256>
+class ObjectPool
+{
+private:
+    struct Slot
+    {
+        typename std::aligned_storage<sizeof(T), std::alignment_of<T>::value>::type storage; // Must stay first
+        Slot *nextFree;
+        bool live;
+    };
+
+    struct Slab
+    {
+        Slot slots[SlabSize];
+    };
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<Slab>> slabs;
+    Slot *freeList;
+    size_t liveCount;
+
+    ObjectPool(const ObjectPool &);
+    ObjectPool &operator=(const ObjectPool &);
+
+    static T *objectIn(Slot *slot)
+    {
+        return reinterpret_cast<T *>(&slot->storage);
+    }
+
+    void addSlab()
+    {
+        slabs.push_back(std::unique_ptr<Slab>(new Slab));
+        Slab &slab = *slabs.back();
+        // Thread the new slots onto the free list, lowest address first
+        for (size_t i = SlabSize; i > 0; --i)
+        {
+            slab.slots[i - 1].live = false;
+            slab.slots[i - 1].nextFree = freeList;
+            freeList = &slab.slots[i - 1];
+        }
+    }
+
+public:
+    ObjectPool() : freeList(nullptr), liveCount(0) {}
+
+    ~ObjectPool()
+    {
+        clear();
+    }
+
+    // Construct a T in the pool
+    template <class... Args>
+    T *create(Args &&... args)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeList)
+        {
+            addSlab();
+        }
+        Slot *slot = freeList;
+        T *object = new (&slot->storage) T(std::forward<Args>(args)...);
+        freeList = slot->nextFree;
+        slot->live = true;
+        ++liveCount;
+        return object;
+    }
+
+    // Destroy an object created by this pool and recycle its slot
+    void destroy(T *object)
+    {
+        if (!object)
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        Slot *slot = reinterpret_cast<Slot *>(object);
+        object->~T();
+        slot->live = false;
+        slot->nextFree = freeList;
+        freeList = slot;
+        --liveCount;
+    }
+
+    // Destroy every live object and release all slabs
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t s = 0; s < slabs.size(); ++s)
+        {
+            for (size_t i = 0; i < SlabSize; ++i)
+            {
+                Slot &slot = slabs[s]->slots[i];
+                if (slot.live)
+                {
+                    objectIn(&slot)->~T();
+                }
+            }
+        }
+        slabs.clear();
+        freeList = nullptr;
+        liveCount = 0;
+    }
+
+    PoolStats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        PoolStats stats;
+        stats.liveObjects = liveCount;
+        stats.capacity = slabs.size() * SlabSize;
+        stats.slabCount = slabs.size();
+        stats.bytesReserved = slabs.size() * sizeof(Slab);
+        stats.bytesInUse = liveCount * sizeof(Slot);
+        return stats;
+    }
+};
+
+#endif // OBJECTPOOL_H
@@ -0,0 +1,110 @@
+#include "PendingRequestQueue.h"
+#include "Trip.h"
+
+PendingRequestQueue::PendingRequestQueue() : nextOrder(0) {}
+
+void PendingRequestQueue::insert(const PendingRequest &request)
+{
+    int node = request.trip->getPickup();
+    if (node < 0)
+    {
+        return;
+    }
+    if (node >= (int)byNode.size())
+    {
+        byNode.resize(node + 1);
+    }
+    byNode[node].push_back(request);
+    byAge[request.order] = request.trip;
+}
+
+void PendingRequestQueue::push(Trip *trip, const std::function<void(const Trip *)> &logPush)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    PendingRequest request = {trip, nextOrder++};
+    insert(request);
+    if (logPush)
+    {
+        logPush(trip);
+    }
+}
+
+void PendingRequestQueue::restore(const PendingRequest &request)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    insert(request);
+}
+
+bool PendingRequestQueue::remove(Trip *trip, PendingRequest *removed)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    int node = trip->getPickup();
+    if (node < 0 || node >= (int)byNode.size())
+    {
+        return false;
+    }
+
+    std::vector<PendingRequest> &entries = byNode[node];
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (entries[i].trip == trip)
+        {
+            if (removed)
+            {
+                *removed = entries[i];
+            }
+            byAge.erase(entries[i].order);
+            // Order inside a bucket does not matter
+            entries[i] = entries.back();
+            entries.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PendingRequestQueue::contains(const Trip *trip) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    int node = trip->getPickup();
+    if (node < 0 || node >= (int)byNode.size())
+    {
+        return false;
+    }
+    for (const PendingRequest &request : byNode[node])
+    {
+        if (request.trip == trip)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<PendingRequest> PendingRequestQueue::getWaitingAt(int node) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (node < 0 || node >= (int)byNode.size())
+    {
+        return std::vector<PendingRequest>();
+    }
+    return byNode[node];
+}
+
+std::vector<Trip *> PendingRequestQueue::getWaiting() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Trip *> result;
+    result.reserve(byAge.size());
+    for (std::map<unsigned long long, Trip *>::const_iterator it = byAge.begin(); it != byAge.end(); ++it)
+    {
+        result.push_back(it->second);
+    }
+    return result;
+}
+
+size_t PendingRequestQueue::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return byAge.size();
+}
@@ -0,0 +1,52 @@
+#ifndef PENDINGREQUESTQUEUE_H
+#define PENDINGREQUESTQUEUE_H
+
+#include <vector>
+#include <map>
+#include <cstddef>
+#include <mutex>
+#include <functional>
+
+class Trip;
+
+// A trip waiting for a driver
+struct PendingRequest
+{
+    Trip *trip;
+    unsigned long long order; // Arrival order: lower has waited longer
+};
+
+// Trips no driver could take yet, oldest first, also bucketed by pickup
+// node so a driver who becomes free can look for demand near themselves
+// instead of walking the whole backlog.
+// All members lock internally; lookups return copies.
+class PendingRequestQueue
+{
+private:
+    mutable std::mutex mutex;
+    std::map<unsigned long long, Trip *> byAge;
+    std::vector<std::vector<PendingRequest>> byNode;
+    unsigned long long nextOrder;
+
+    void insert(const PendingRequest &request);
+
+public:
+    PendingRequestQueue();
+
+    // Start waiting, behind everyone already queued. logPush runs under the
+    // queue's lock, so the event log sees trips join in queue order
+    void push(Trip *trip, const std::function<void(const Trip *)> &logPush = nullptr);
+    // Put a removed request back in its old place in line
+    void restore(const PendingRequest &request);
+    // Stop waiting; false if the trip was not queued (e.g. another driver took it)
+    bool remove(Trip *trip, PendingRequest *removed = nullptr);
+    bool contains(const Trip *trip) const;
+
+    // Requests waiting at a pickup node
+    std::vector<PendingRequest> getWaitingAt(int node) const;
+    // Every waiting trip, longest wait first
+    std::vector<Trip *> getWaiting() const;
+    size_t size() const;
+};
+
+#endif // PENDINGREQUESTQUEUE_H
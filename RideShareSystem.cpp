@@ -5,31 +5,45 @@
 #include <iostream>
 #include <cstdio>
 #include <climits>
+#include <algorithm>
 
-RideShareSystem::RideShareSystem() : nextDriverId(0), nextRiderId(0), nextTripId(0) {}
+namespace
+{
+TripRecord recordOf(const Trip *trip)
+{
+    TripRecord record;
+    record.tripId = trip->getId();
+    record.riderId = trip->getRider()->getId();
+    record.driverId = trip->getDriver() ? trip->getDriver()->getId() : -1;
+    record.pickup = trip->getPickup();
+    record.dropoff = trip->getDropoff();
+    record.state = trip->getStatus();
+    record.fare = trip->getFare();
+    record.requestedAt = trip->getRequestedAt();
+    record.finishedAt = trip->getFinishedAt();
+    return record;
+}
 
-RideShareSystem::~RideShareSystem()
+bool tripById(const Trip *a, const Trip *b)
 {
-    // Clean up drivers
-    for (Driver *driver : drivers)
-    {
-        delete driver;
-    }
-    drivers.clear();
+    return a->getId() < b->getId();
+}
 
-    // Clean up riders
-    for (Rider *rider : riders)
-    {
-        delete rider;
-    }
-    riders.clear();
+bool recordById(const TripRecord &a, const TripRecord &b)
+{
+    return a.tripId < b.tripId;
+}
+} // namespace
 
-    // Clean up trips
-    for (Trip *trip : trips)
-    {
-        delete trip;
-    }
-    trips.clear();
+RideShareSystem::RideShareSystem()
+    : driverIndex(driverStore), locationIngest(city, driverStore), nextRiderId(0), batchDispatch(false), batchWindowMs(0),
+      replaying(false), logSegment(1), snapshotEvery(0), eventsAtSnapshot(0), snapshotBusy(false) {}
+
+RideShareSystem::~RideShareSystem()
+{
+    waitForSnapshot();
+    // Nothing to free by hand: tripStore is declared after riderPool, so the
+    // trips' slabs go first, then the riders' slabs they point into
 }
 
 void RideShareSystem::addLocation(const std::string &name, int zoneID)
@@ -42,30 +56,94 @@ void RideShareSystem::addRoad(const std::string &locationA, const std::string &l
     city.addRoad(locationA, locationB, distance);
 }
 
+void RideShareSystem::setRoutingMode(RoutingMode mode)
+{
+    city.setRoutingMode(mode);
+}
+
+bool RideShareSystem::loadOrBuildContractionHierarchy(const std::string &indexPath)
+{
+    if (!city.loadContractionHierarchy(indexPath))
+    {
+        std::cout << "[SETUP] Building contraction hierarchy...\n";
+        city.buildContractionHierarchy();
+        if (!city.saveContractionHierarchy(indexPath))
+        {
+            return false;
+        }
+    }
+
+    std::cout << "[OK] Contraction hierarchy ready ("
+              << city.getContractionHierarchy().getShortcutCount() << " shortcuts)\n";
+    city.setRoutingMode(ROUTE_CONTRACTION_HIERARCHY);
+    return true;
+}
+
 Driver *RideShareSystem::addDriver(const std::string &name, const std::string &carModel,
                                    const std::string &numberPlate, const std::string &location, int zoneID)
 {
-    Driver *newDriver = new Driver(nextDriverId++, name, carModel, numberPlate, location, zoneID);
-    drivers.push_back(newDriver);
-    return newDriver;
+    SharedLock gate(stateGate);
+    Driver *driver = driverStore.add(name, carModel, numberPlate, city.findNodeByName(location), zoneID);
+    if (driver)
+    {
+        LogEvent event(EVENT_DRIVER_ADDED);
+        event.driverId = driver->getId();
+        event.name = name;
+        event.carModel = carModel;
+        event.numberPlate = numberPlate;
+        event.node = driver->getCurrentLocation();
+        event.zone = zoneID;
+        logEvent(event);
+        commitEvents();
+    }
+    return driver;
 }
 
 Driver *RideShareSystem::addDriver(const std::string &name, const std::string &location, int zoneID)
 {
     // Create a driver with default car model and number plate
-    Driver *newDriver = new Driver(nextDriverId++, name, "Unknown", "Unknown", location, zoneID);
-    drivers.push_back(newDriver);
-    return newDriver;
+    return addDriver(name, "Unknown", "Unknown", location, zoneID);
 }
 
 Rider *RideShareSystem::addRider(const std::string &name, const std::string &location)
 {
-    Rider *newRider = new Rider(nextRiderId++, name, location);
-    riders.push_back(newRider);
+    return addRider(name, city.findNodeByName(location));
+}
+
+Rider *RideShareSystem::addRider(const std::string &name, int location)
+{
+    SharedLock gate(stateGate);
+    Rider *newRider = riderPool.create(nextRiderId++, name, location);
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        riders.push_back(newRider);
+    }
+
+    LogEvent event(EVENT_RIDER_ADDED);
+    event.riderId = newRider->getId();
+    event.name = name;
+    event.node = newRider->getLocation();
+    logEvent(event);
+    commitEvents();
     return newRider;
 }
 
 Trip *RideShareSystem::requestTrip(Rider *rider, const std::string &pickup, const std::string &dropoff, Driver *manualDriver)
+{
+    // Resolve names to node IDs once; everything downstream works on IDs
+    int pickupId = city.findNodeByName(pickup);
+    int dropoffId = city.findNodeByName(dropoff);
+
+    if (pickupId == -1 || dropoffId == -1)
+    {
+        std::cerr << "Error: Pickup or dropoff location not found\n";
+        return nullptr;
+    }
+
+    return requestTrip(rider, pickupId, dropoffId, manualDriver);
+}
+
+Trip *RideShareSystem::requestTrip(Rider *rider, int pickup, int dropoff, Driver *manualDriver)
 {
     if (!rider)
     {
@@ -73,51 +151,291 @@ Trip *RideShareSystem::requestTrip(Rider *rider, const std::string &pickup, cons
         return nullptr;
     }
 
-    // Create the trip
-    Trip *newTrip = new Trip(nextTripId++, rider, pickup, dropoff, -1);
-    newTrip->setCity(&city); // Set city reference for distance calculation
-    trips.push_back(newTrip);
+    Trip *newTrip = nullptr;
+    bool batched = false;
+    {
+        SharedLock gate(stateGate);
+        // Create the trip
+        newTrip = tripStore.create(rider, pickup, dropoff);
+        TripChangeGuard guard(rollbackManager, newTrip);
+        newTrip->setCity(&city); // Set city reference for distance calculation
+
+        LogEvent event(EVENT_TRIP_REQUESTED);
+        event.tripId = newTrip->getId();
+        event.riderId = rider->getId();
+        event.node = pickup;
+        event.dropoff = dropoff;
+        event.timestamp = newTrip->getRequestedAt();
+        logEvent(event);
+
+        // Record initial state
+        recordUndo(newTrip);
+
+        // In batch mode the trip waits for the window to close, unless a driver was picked by hand
+        if (batchDispatch && !manualDriver)
+        {
+            {
+                std::lock_guard<std::mutex> lock(batchMutex);
+                if (pendingBatch.empty())
+                {
+                    batchOpenedAt = std::chrono::steady_clock::now();
+                }
+                pendingBatch.push_back(newTrip);
+            }
+            std::cout << "[INFO] Trip #" << newTrip->getId() << " queued for batch dispatch.\n";
+            batched = true;
+        }
+        else
+        {
+            // Assign driver: if a manualDriver was provided, use it and skip search.
+            Driver *assignedDriver = nullptr;
+            if (manualDriver)
+            {
+                std::cout << "[INFO] Manual override requested. Assigning selected driver.\n";
+                if (manualDriver->tryReserve())
+                {
+                    assignedDriver = manualDriver;
+                }
+            }
+            else
+            {
+                // Find and claim nearest available driver
+                assignedDriver = reserveNearestDriver(pickup);
+            }
 
-    // Record initial state
-    rollbackManager.recordState(newTrip);
+            if (assignedDriver)
+            {
+                assignDriver(newTrip, assignedDriver, manualDriver != nullptr);
+            }
+            else
+            {
+                if (manualDriver)
+                {
+                    std::cout << "\n[ERROR] Selected driver is no longer available!\n\n";
+                }
+                else
+                {
+                    std::cout << "\n[ERROR] No available drivers at the moment!\n\n";
+                }
+                // Either way the request stays open, as it would after a restart
+                waitForDriver(newTrip);
+            }
+        }
+    }
 
-    // Assign driver: if a manualDriver was provided, use it and skip search.
-    Driver *assignedDriver = nullptr;
-    if (manualDriver)
+    // Outside the guard: the batch may hold this trip, and dispatching
+    // changes each trip in it (and takes the gate itself)
+    if (batched)
     {
-        assignedDriver = manualDriver;
-        std::cout << "[INFO] Manual override requested. Assigning selected driver.\n";
+        pollDispatchBatch();
     }
-    else
+    commitEvents();
+    return newTrip;
+}
+
+Driver *RideShareSystem::reserveNearestDriver(int pickup)
+{
+    // The search reads a fleet other bookings are changing; if one of them
+    // claims our pick first, it has left the index, so searching again finds
+    // the next best driver
+    while (true)
     {
-        // Find and assign nearest available driver
-        assignedDriver = dispatchEngine.findNearestDriver(city, drivers, pickup);
+        Driver *candidate = dispatchEngine.findNearestDriver(city, driverIndex, pickup);
+        if (!candidate || candidate->tryReserve())
+        {
+            return candidate;
+        }
     }
+}
+
+void RideShareSystem::moveDriver(Driver *driver, int node)
+{
+    // Zone first: a driver seen at the new node is already filed in its zone
+    driver->setZoneID(city.getZone(node));
+    driver->setCurrentLocation(node);
+}
+
+void RideShareSystem::assignDriver(Trip *trip, Driver *driver, bool manual)
+{
+    LogEvent event(EVENT_TRIP_ASSIGNED);
+    event.tripId = trip->getId();
+    event.driverId = driver->getId();
+    logEvent(event);
 
-    if (assignedDriver)
+    trip->setDriver(driver);
+    trip->setStatus(ASSIGNED);
+    moveDriver(driver, trip->getPickup());
+
+    if (manual)
     {
-        newTrip->setDriver(assignedDriver);
-        newTrip->setStatus(ASSIGNED);
-        assignedDriver->setAvailable(false);
-        assignedDriver->setCurrentLocation(pickup);
+        std::cout << "Manual Override: Driver " << driver->getName() << " assigned successfully." << std::endl;
+    }
+
+    std::cout << "\n[OK] TRIP BOOKED\n";
+    std::cout << "    Trip ID: " << trip->getId() << "\n";
+    std::cout << "    Driver: " << driver->getName() << " (" << driver->getCarModel() << ")\n";
+    std::cout << "    Number Plate: " << driver->getNumberPlate() << "\n";
+    std::cout << "    Route: " << trip->getPickupName() << " -> " << trip->getDropoffName() << "\n\n";
+}
 
-        if (manualDriver)
+void RideShareSystem::enableBatchDispatch(int windowMs)
+{
+    batchDispatch = true;
+    batchWindowMs = windowMs < 0 ? 0 : windowMs;
+}
+
+void RideShareSystem::disableBatchDispatch()
+{
+    flushDispatchBatch();
+    batchDispatch = false;
+}
+
+bool RideShareSystem::isBatchDispatchEnabled() const
+{
+    return batchDispatch;
+}
+
+void RideShareSystem::pollDispatchBatch()
+{
+    SharedLock gate(stateGate);
+    std::vector<Trip *> batch;
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        if (pendingBatch.empty())
         {
-            std::cout << "Manual Override: Driver " << assignedDriver->getName() << " assigned successfully." << std::endl;
+            return;
+        }
+        std::chrono::steady_clock::duration waited = std::chrono::steady_clock::now() - batchOpenedAt;
+        if (waited < std::chrono::milliseconds(batchWindowMs))
+        {
+            return;
         }
+        batch.swap(pendingBatch);
+    }
+    dispatchBatch(batch);
+}
 
-        std::cout << "\n[OK] TRIP BOOKED\n";
-        std::cout << "    Trip ID: " << newTrip->getId() << "\n";
-        std::cout << "    Driver: " << assignedDriver->getName() << " (" << assignedDriver->getCarModel() << ")\n";
-        std::cout << "    Number Plate: " << assignedDriver->getNumberPlate() << "\n";
-        std::cout << "    Route: " << pickup << " -> " << dropoff << "\n\n";
+size_t RideShareSystem::flushDispatchBatch()
+{
+    SharedLock gate(stateGate);
+    std::vector<Trip *> batch;
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        batch.swap(pendingBatch);
     }
-    else
+    return dispatchBatch(batch);
+}
+
+size_t RideShareSystem::dispatchBatch(const std::vector<Trip *> &queued)
+{
+    // Requests cancelled (or undone) while they waited drop out of the batch
+    std::vector<Trip *> batch;
+    std::vector<int> pickups;
+    for (Trip *trip : queued)
     {
-        std::cout << "\n[ERROR] No available drivers at the moment!\n\n";
+        TripChangeGuard guard(rollbackManager, trip);
+        if (trip->getStatus() == REQUESTED && !trip->getDriver())
+        {
+            batch.push_back(trip);
+            pickups.push_back(trip->getPickup());
+        }
     }
 
-    return newTrip;
+    if (batch.empty())
+    {
+        return 0;
+    }
+
+    std::vector<Driver *> assigned = dispatchEngine.assignBatch(city, driverIndex, pickups);
+
+    size_t assignedCount = 0;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        TripChangeGuard guard(rollbackManager, batch[i]);
+        if (batch[i]->getStatus() != REQUESTED || batch[i]->getDriver())
+        {
+            continue; // Cancelled or undone while the batch was solved
+        }
+        Driver *driver = assigned[i];
+        if (driver && !driver->tryReserve())
+        {
+            // Claimed by a one-off booking since the batch was solved
+            driver = reserveNearestDriver(pickups[i]);
+        }
+
+        if (driver)
+        {
+            assignDriver(batch[i], driver, false);
+            ++assignedCount;
+        }
+        else
+        {
+            std::cout << "\n[ERROR] No available driver for Trip #" << batch[i]->getId() << "!\n\n";
+            waitForDriver(batch[i]);
+        }
+    }
+
+    std::cout << "[INFO] Batch dispatch assigned " << assignedCount << " of " << batch.size() << " requests.\n";
+    commitEvents();
+    return assignedCount;
+}
+
+void RideShareSystem::waitForDriver(Trip *trip)
+{
+    // Logged so replay rebuilds the queue in the same order
+    waitingRequests.push(trip, [this](const Trip *queued)
+    {
+        LogEvent event(EVENT_REQUEST_WAITING);
+        event.tripId = queued->getId();
+        logEvent(event);
+    });
+    std::cout << "[INFO] Trip #" << trip->getId() << " will be matched as soon as a driver is free.\n";
+}
+
+void RideShareSystem::redispatchReleasedDriver(Driver *driver)
+{
+    // Only this driver is new supply, so only demand near them needs a look
+    while (waitingRequests.size() > 0)
+    {
+        Trip *trip = dispatchEngine.findNearestRequest(city, waitingRequests, driver);
+        if (!trip)
+        {
+            return;
+        }
+
+        PendingRequest claimed;
+        if (!waitingRequests.remove(trip, &claimed))
+        {
+            continue; // Another released driver matched it first
+        }
+        TripChangeGuard guard(rollbackManager, trip);
+        if (trip->getStatus() != REQUESTED || trip->getDriver())
+        {
+            continue; // Changed by an undo while it waited
+        }
+        if (!driver->tryReserve())
+        {
+            // Booked by someone else meanwhile; the request keeps its place in line
+            waitingRequests.restore(claimed);
+            return;
+        }
+
+        std::cout << "[INFO] Driver " << driver->getName() << " is free; matching waiting Trip #" << trip->getId() << ".\n";
+        recordUndo(trip);
+        assignDriver(trip, driver, false);
+        return;
+    }
+}
+
+std::vector<Trip *> RideShareSystem::getWaitingRequests() const
+{
+    return waitingRequests.getWaiting();
+}
+
+size_t RideShareSystem::getPendingBatchSize() const
+{
+    std::lock_guard<std::mutex> lock(batchMutex);
+    return pendingBatch.size();
 }
 
 bool RideShareSystem::completeTrip(Trip *trip)
@@ -128,26 +446,58 @@ bool RideShareSystem::completeTrip(Trip *trip)
         return false;
     }
 
-    // Record state before change
-    rollbackManager.recordState(trip);
+    SharedLock gate(stateGate);
+    Driver *driver = nullptr;
+    {
+        // Checked under the guard: an undo could otherwise bring the trip back
+        // between the check and the change
+        TripChangeGuard guard(rollbackManager, trip);
+        if (trip->getStatus() == COMPLETED || trip->getStatus() == CANCELLED)
+        {
+            std::cerr << "Error: Trip #" << trip->getId() << " is already finished\n";
+            return false;
+        }
+        if (!trip->getDriver())
+        {
+            // Still waiting for a driver, so nobody drove it
+            std::cerr << "Error: Trip #" << trip->getId() << " has no driver yet; cancel it instead\n";
+            return false;
+        }
 
-    // Calculate fare before marking as completed
-    trip->calculateFare();
+        // Record state before change
+        recordUndo(trip);
 
-    trip->setStatus(COMPLETED);
+        // Calculate fare before marking as completed
+        trip->calculateFare();
 
-    Driver *driver = trip->getDriver();
-    if (driver)
-    {
-        driver->setAvailable(true);
-        driver->setCurrentLocation(trip->getDropoff());
-    }
+        trip->setStatus(COMPLETED);
+
+        // Logged before the driver is released, so their next booking replays after this
+        LogEvent event(EVENT_TRIP_COMPLETED);
+        event.tripId = trip->getId();
+        event.timestamp = trip->getFinishedAt();
+        logEvent(event);
 
-    std::cout << "[OK] Trip #" << trip->getId() << " completed.\n";
+        driver = trip->getDriver();
+        if (driver)
+        {
+            // Move the driver before releasing them, so nobody books them at the old spot
+            moveDriver(driver, trip->getDropoff());
+            driver->setAvailable(true);
+        }
 
-    // Generate and display receipt
-    trip->generateReceipt();
+        std::cout << "[OK] Trip #" << trip->getId() << " completed.\n";
 
+        // Generate and display receipt
+        trip->generateReceipt();
+    }
+
+    // Outside the guard: matching the driver changes another trip
+    if (driver)
+    {
+        redispatchReleasedDriver(driver);
+    }
+    commitEvents();
     return true;
 }
 
@@ -159,43 +509,657 @@ bool RideShareSystem::cancelTrip(Trip *trip)
         return false;
     }
 
-    // Record state before change
-    rollbackManager.recordState(trip);
+    SharedLock gate(stateGate);
+    Driver *driver = nullptr;
+    {
+        // Checked under the guard: an undo could otherwise bring the trip back
+        // between the check and the change
+        TripChangeGuard guard(rollbackManager, trip);
+        if (trip->getStatus() == COMPLETED || trip->getStatus() == CANCELLED)
+        {
+            std::cerr << "Error: Trip #" << trip->getId() << " is already finished\n";
+            return false;
+        }
+
+        // Record state before change
+        recordUndo(trip);
+
+        trip->setStatus(CANCELLED);
+        waitingRequests.remove(trip);
+
+        LogEvent event(EVENT_TRIP_CANCELLED);
+        event.tripId = trip->getId();
+        event.timestamp = trip->getFinishedAt();
+        logEvent(event);
 
-    trip->setStatus(CANCELLED);
+        driver = trip->getDriver();
+        if (driver)
+        {
+            driver->setAvailable(true);
+        }
+
+        std::cout << "[OK] Trip #" << trip->getId() << " cancelled.\n";
+    }
 
-    Driver *driver = trip->getDriver();
+    // Outside the guard: matching the driver changes another trip
     if (driver)
     {
-        driver->setAvailable(true);
+        redispatchReleasedDriver(driver);
     }
-
-    std::cout << "[OK] Trip #" << trip->getId() << " cancelled.\n";
+    commitEvents();
     return true;
 }
 
 bool RideShareSystem::undoLastAction()
 {
-    bool success = rollbackManager.undoLastOperation();
+    SharedLock gate(stateGate);
+    UndoOutcome outcome = {nullptr, nullptr};
+    // Logged under the stack's lock, naming the trip, so replay pops the same entry
+    bool success = rollbackManager.undoLastOperation(&outcome, [this](const Trip *undone)
+    {
+        LogEvent event(EVENT_UNDO);
+        event.tripId = undone->getId();
+        logEvent(event);
+    });
     if (success)
     {
         std::cout << "[OK] Undo completed successfully\n";
+
+        // The freed driver goes to requests that were already waiting, then
+        // the undone trip joins the back of the line (unless it never left
+        // it or is still in the batch)
+        if (outcome.releasedDriver)
+        {
+            redispatchReleasedDriver(outcome.releasedDriver);
+        }
+        Trip *trip = outcome.trip;
+        {
+            TripChangeGuard guard(rollbackManager, trip);
+            bool batched;
+            {
+                std::lock_guard<std::mutex> lock(batchMutex);
+                batched = std::find(pendingBatch.begin(), pendingBatch.end(), trip) != pendingBatch.end();
+            }
+            if (trip->getStatus() == REQUESTED && !trip->getDriver() && !batched && !waitingRequests.contains(trip))
+            {
+                waitForDriver(trip);
+            }
+        }
+        commitEvents();
     }
-    else
+    else if (rollbackManager.getStackSize() == 0)
     {
         std::cout << "[ERROR] Nothing to undo\n";
     }
+    else
+    {
+        std::cout << "[ERROR] Undo not possible right now\n";
+    }
     return success;
 }
 
-const std::vector<Trip *> &RideShareSystem::getAllTrips() const
+void RideShareSystem::logEvent(const LogEvent &event)
+{
+    if (!replaying)
+    {
+        eventLog.append(event);
+    }
+}
+
+void RideShareSystem::commitEvents()
+{
+    if (!replaying && eventLog.isOpen())
+    {
+        eventLog.sync();
+    }
+}
+
+void RideShareSystem::recordUndo(Trip *trip)
+{
+    // Logged under the stack's lock, so concurrent pushes replay in stack order
+    rollbackManager.recordState(trip, [this](const Trip *recorded)
+    {
+        LogEvent event(EVENT_STATE_RECORDED);
+        event.tripId = recorded->getId();
+        logEvent(event);
+    });
+}
+
+bool RideShareSystem::replayEvent(const LogEvent &event)
+{
+    Trip *trip = tripStore.get(event.tripId);
+    Driver *driver = trip ? trip->getDriver() : nullptr;
+
+    switch (event.type)
+    {
+    case EVENT_DRIVER_ADDED:
+    {
+        if (event.driverId < (int)driverStore.size())
+        {
+            return true; // Registered again by the fleet setup
+        }
+        Driver *added = driverStore.add(event.name, event.carModel, event.numberPlate, event.node, event.zone);
+        return added && added->getId() == event.driverId;
+    }
+    case EVENT_RIDER_ADDED:
+    {
+        if (findRiderById(event.riderId))
+        {
+            return true;
+        }
+        Rider *rider = riderPool.create(event.riderId, event.name, event.node);
+        std::lock_guard<std::mutex> lock(registryMutex);
+        riders.push_back(rider);
+        if (nextRiderId <= event.riderId)
+        {
+            nextRiderId = event.riderId + 1;
+        }
+        return true;
+    }
+    case EVENT_TRIP_REQUESTED:
+    {
+        Rider *rider = findRiderById(event.riderId);
+        trip = rider ? tripStore.recreate(event.tripId, rider, event.node, event.dropoff) : nullptr;
+        if (!trip)
+        {
+            return false;
+        }
+        trip->setCity(&city);
+        trip->restoreTimes(event.timestamp, 0);
+        return true;
+    }
+    case EVENT_STATE_RECORDED:
+        if (!trip)
+        {
+            return false;
+        }
+        rollbackManager.recordState(trip);
+        return true;
+    case EVENT_TRIP_ASSIGNED:
+        driver = driverStore.get(event.driverId);
+        if (!trip || !driver)
+        {
+            return false;
+        }
+        waitingRequests.remove(trip);
+        driver->setAvailable(false);
+        trip->setDriver(driver);
+        trip->setStatus(ASSIGNED);
+        moveDriver(driver, trip->getPickup());
+        return true;
+    case EVENT_TRIP_COMPLETED:
+        if (!trip)
+        {
+            return false;
+        }
+        trip->calculateFare();
+        trip->setStatus(COMPLETED);
+        trip->restoreTimes(trip->getRequestedAt(), event.timestamp);
+        waitingRequests.remove(trip); // Older logs may complete a waiting request
+        if (driver)
+        {
+            moveDriver(driver, trip->getDropoff());
+            driver->setAvailable(true);
+        }
+        return true;
+    case EVENT_TRIP_CANCELLED:
+        if (!trip)
+        {
+            return false;
+        }
+        trip->setStatus(CANCELLED);
+        trip->restoreTimes(trip->getRequestedAt(), event.timestamp);
+        waitingRequests.remove(trip);
+        if (driver)
+        {
+            driver->setAvailable(true);
+        }
+        return true;
+    case EVENT_UNDO:
+    {
+        // Older logs don't name the trip
+        const Trip *last = rollbackManager.getLastTrip();
+        if (event.tripId >= 0 && (!last || last->getId() != event.tripId))
+        {
+            return false;
+        }
+        return rollbackManager.undoLastOperation();
+    }
+    case EVENT_REQUEST_WAITING:
+        if (!trip)
+        {
+            return false;
+        }
+        waitingRequests.remove(trip);
+        waitingRequests.push(trip);
+        return true;
+    }
+    return false;
+}
+
+bool RideShareSystem::openEventLog(const std::string &path)
 {
-    return trips;
+    std::vector<LogEvent> events;
+    if (!eventLog.open(path, logSegment, events))
+    {
+        return false;
+    }
+
+    replaying = true;
+    size_t failed = 0;
+    for (const LogEvent &event : events)
+    {
+        if (!replayEvent(event))
+        {
+            ++failed;
+        }
+    }
+
+    // Whatever was still unmatched waits for the next free driver
+    queueUnmatchedRequests();
+    replaying = false;
+
+    if (failed > 0)
+    {
+        std::cerr << "Error: " << failed << " logged events in " << path << " could not be replayed\n";
+    }
+    if (!events.empty())
+    {
+        std::cout << "[OK] Recovered " << tripStore.size() << " trips from " << events.size()
+                  << " logged events in " << path << "\n";
+    }
+    return true;
+}
+
+LogStats RideShareSystem::getEventLogStats() const
+{
+    return eventLog.getStats();
+}
+
+void RideShareSystem::queueUnmatchedRequests()
+{
+    std::vector<Trip *> requested = tripStore.getInState(REQUESTED);
+    std::sort(requested.begin(), requested.end(), tripById);
+    for (Trip *trip : requested)
+    {
+        if (!trip->getDriver() && !waitingRequests.contains(trip))
+        {
+            waitingRequests.push(trip);
+        }
+    }
+}
+
+void RideShareSystem::enableSnapshots(const std::string &path, size_t everyEvents)
+{
+    snapshotPath = path;
+    snapshotEvery = everyEvents;
+}
+
+void RideShareSystem::captureSnapshot(SystemSnapshot &snapshot) const
+{
+    snapshot.locations = city.getAllNodes();
+    snapshot.roads.clear();
+    for (const Node &node : snapshot.locations)
+    {
+        // Each road is listed at both ends; keep it once
+        bool skipLoop = false;
+        for (const Edge &edge : city.getRoads(node.id))
+        {
+            if (edge.destination == node.id)
+            {
+                skipLoop = !skipLoop;
+                if (!skipLoop)
+                {
+                    continue;
+                }
+            }
+            else if (edge.destination < node.id)
+            {
+                continue;
+            }
+            RoadRecord road;
+            road.from = node.id;
+            road.to = edge.destination;
+            road.distance = edge.weight;
+            snapshot.roads.push_back(road);
+        }
+    }
+    snapshot.cities = cities;
+
+    snapshot.drivers.resize(driverStore.size());
+    for (size_t i = 0; i < snapshot.drivers.size(); ++i)
+    {
+        DriverRecord &driver = snapshot.drivers[i];
+        driver.name = driverStore.getName((int)i);
+        driver.carModel = driverStore.getCarModel((int)i);
+        driver.numberPlate = driverStore.getNumberPlate((int)i);
+        driver.location = driverStore.getLocation((int)i);
+        driver.zone = driverStore.getZone((int)i);
+        driver.available = driverStore.isAvailable((int)i);
+    }
+
+    snapshot.riders.clear();
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const Rider *rider : riders)
+        {
+            RiderRecord record;
+            record.id = rider->getId();
+            record.name = rider->getName();
+            record.location = rider->getLocation();
+            snapshot.riders.push_back(record);
+        }
+    }
+
+    snapshot.nextTripId = (int)tripStore.getCreatedCount();
+    snapshot.trips.clear();
+    for (const Trip *trip : tripStore.getAll())
+    {
+        snapshot.trips.push_back(recordOf(trip));
+    }
+    // Sealed segments are shared with the archive, not decoded or copied
+    tripArchive.getContents(snapshot.archivedSegments, snapshot.archived);
+
+    snapshot.undo.clear();
+    for (const TripAction &action : rollbackManager.getActions())
+    {
+        UndoRecord record;
+        record.tripId = action.trip->getId();
+        record.oldState = action.oldState;
+        record.driverId = action.assignedDriver ? action.assignedDriver->getId() : -1;
+        snapshot.undo.push_back(record);
+    }
+}
+
+bool RideShareSystem::takeSnapshot()
+{
+    if (snapshotPath.empty() || snapshotBusy || !eventLog.isOpen())
+    {
+        return false;
+    }
+
+    std::shared_ptr<SystemSnapshot> snapshot(new SystemSnapshot());
+    {
+        // No change is between its effect and its log entry while this is held
+        std::lock_guard<SharedMutex> lock(stateGate);
+        captureSnapshot(*snapshot);
+        // Everything logged so far is in the copy; later events go to a new segment
+        unsigned segment = eventLog.roll();
+        if (segment == 0)
+        {
+            return false;
+        }
+        snapshot->logSegment = segment;
+        eventsAtSnapshot = eventLog.getStats().events;
+    }
+
+    writeSnapshotAsync(snapshot);
+    return true;
+}
+
+void RideShareSystem::writeSnapshotAsync(const std::shared_ptr<SystemSnapshot> &snapshot)
+{
+    if (snapshotWriter.joinable())
+    {
+        snapshotWriter.join();
+    }
+    snapshotBusy = true;
+    std::string path = snapshotPath;
+    snapshotWriter = std::thread([this, snapshot, path]()
+    {
+        if (writeSnapshot(path, *snapshot))
+        {
+            eventLog.dropSegmentsBefore(snapshot->logSegment);
+        }
+        snapshotBusy = false;
+    });
 }
 
-const std::vector<Driver *> &RideShareSystem::getAllDrivers() const
+void RideShareSystem::pollSnapshot()
 {
-    return drivers;
+    if (snapshotEvery > 0 && eventLog.getStats().events - eventsAtSnapshot >= snapshotEvery)
+    {
+        takeSnapshot();
+    }
+}
+
+void RideShareSystem::waitForSnapshot()
+{
+    if (snapshotWriter.joinable())
+    {
+        snapshotWriter.join();
+    }
+}
+
+bool RideShareSystem::loadSnapshot()
+{
+    if (snapshotPath.empty() || !city.getAllNodes().empty() || driverStore.size() > 0 || tripStore.getCreatedCount() > 0)
+    {
+        return false;
+    }
+    SystemSnapshot snapshot;
+    if (!readSnapshot(snapshotPath, snapshot))
+    {
+        return false;
+    }
+    // First, while nothing else is restored: the segments are checked here
+    if (!tripArchive.restore(snapshot.archivedSegments, snapshot.archived))
+    {
+        std::cerr << "Error: Snapshot " << snapshotPath << " has a damaged trip archive\n";
+        return false;
+    }
+
+    for (const Node &node : snapshot.locations)
+    {
+        city.addLocation(node.name, node.zoneID);
+    }
+    for (const RoadRecord &road : snapshot.roads)
+    {
+        city.addRoad(road.from, road.to, road.distance);
+    }
+    cities = snapshot.cities;
+
+    for (const DriverRecord &record : snapshot.drivers)
+    {
+        Driver *driver = driverStore.add(record.name, record.carModel, record.numberPlate, record.location, record.zone);
+        if (driver && !record.available)
+        {
+            driver->setAvailable(false);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const RiderRecord &record : snapshot.riders)
+        {
+            riders.push_back(riderPool.create(record.id, record.name, record.location));
+            if (nextRiderId <= record.id)
+            {
+                nextRiderId = record.id + 1;
+            }
+        }
+    }
+
+    for (const TripRecord &record : snapshot.trips)
+    {
+        Rider *rider = findRiderById(record.riderId);
+        Trip *trip = rider ? tripStore.recreate(record.tripId, rider, record.pickup, record.dropoff) : nullptr;
+        if (!trip)
+        {
+            std::cerr << "Error: Snapshot trip #" << record.tripId << " could not be restored\n";
+            continue;
+        }
+        trip->setCity(&city);
+        // Status first: a finished trip must never be filed as its driver's
+        // active one, or finishing it clears the entry of their live trip
+        trip->setStatus(record.state);
+        trip->setDriver(driverStore.get(record.driverId));
+        trip->restoreTimes(record.requestedAt, record.finishedAt);
+        trip->restoreFare(record.fare);
+    }
+    tripStore.skipIds(snapshot.nextTripId);
+
+    std::vector<TripAction> actions;
+    for (const UndoRecord &record : snapshot.undo)
+    {
+        TripAction action;
+        action.trip = tripStore.get(record.tripId);
+        action.oldState = record.oldState;
+        action.assignedDriver = driverStore.get(record.driverId);
+        if (action.trip)
+        {
+            actions.push_back(action);
+        }
+    }
+    rollbackManager.restoreActions(actions);
+    // Ahead of anything the log queues later
+    queueUnmatchedRequests();
+
+    logSegment = snapshot.logSegment;
+    std::cout << "[OK] Restored snapshot " << snapshotPath << " (" << snapshot.trips.size() + tripArchive.size()
+              << " trips)\n";
+    return true;
+}
+
+std::vector<Trip *> RideShareSystem::getAllTrips() const
+{
+    return tripStore.getAll();
+}
+
+size_t RideShareSystem::archiveFinishedTrips()
+{
+    SharedLock gate(stateGate);
+    std::vector<Trip *> finished = tripStore.getInState(COMPLETED);
+    std::vector<Trip *> cancelled = tripStore.getInState(CANCELLED);
+    finished.insert(finished.end(), cancelled.begin(), cancelled.end());
+
+    std::vector<Trip *> batched;
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        batched = pendingBatch;
+    }
+    std::sort(batched.begin(), batched.end());
+
+    size_t archived = 0;
+    for (Trip *trip : finished)
+    {
+        // An undo could bring it back, or a batch or the waiting queue still holds it
+        if (rollbackManager.isReferenced(trip) || std::binary_search(batched.begin(), batched.end(), trip) ||
+            waitingRequests.contains(trip))
+        {
+            continue;
+        }
+        tripArchive.append(recordOf(trip));
+        tripStore.remove(trip);
+        ++archived;
+    }
+    return archived;
+}
+
+Rider *RideShareSystem::findRiderById(int riderId) const
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    // Riders are listed in ID order unless two registered at once
+    if (riderId >= 0 && riderId < (int)riders.size() && riders[riderId]->getId() == riderId)
+    {
+        return riders[riderId];
+    }
+    for (Rider *rider : riders)
+    {
+        if (rider->getId() == riderId)
+        {
+            return rider;
+        }
+    }
+    return nullptr;
+}
+
+void RideShareSystem::printTripRow(const TripRecord &record) const
+{
+    const Rider *rider = findRiderById(record.riderId);
+    const Driver *driver = record.driverId >= 0 ? driverStore.get(record.driverId) : nullptr;
+
+    printf("%2d | %-12s | %-7s | %-7s | %-6s | %s\n",
+           record.tripId,
+           rider ? rider->getName().c_str() : "Unknown",
+           city.getLocationName(record.pickup).c_str(),
+           city.getLocationName(record.dropoff).c_str(),
+           driver ? driver->getName().c_str() : "None",
+           tripStateName(record.state));
+}
+
+void RideShareSystem::displayTripHistory() const
+{
+    std::vector<TripRecord> archived = tripArchive.getRecords();
+    std::sort(archived.begin(), archived.end(), recordById);
+    std::vector<Trip *> resident = tripStore.getAll();
+
+    std::cout << "\n=============== TRIP STATUS ===============\n";
+    std::cout << "ID | Rider        | From    | To      | Driver | Status\n";
+    std::cout << "---+--------------+---------+---------+--------+----------\n";
+
+    // Both lists are in ID order; merge them
+    size_t a = 0;
+    size_t r = 0;
+    while (a < archived.size() || r < resident.size())
+    {
+        if (r == resident.size() || (a < archived.size() && archived[a].tripId < resident[r]->getId()))
+        {
+            printTripRow(archived[a++]);
+        }
+        else
+        {
+            printTripRow(recordOf(resident[r++]));
+        }
+    }
+
+    std::cout << "==========================================\n";
+}
+
+size_t RideShareSystem::getTripCount() const
+{
+    return tripStore.getCreatedCount();
+}
+
+const TripArchive &RideShareSystem::getTripArchive() const
+{
+    return tripArchive;
+}
+
+std::vector<Trip *> RideShareSystem::getActiveTrips() const
+{
+    return tripStore.getActive();
+}
+
+Trip *RideShareSystem::getTripById(int tripId) const
+{
+    return tripStore.get(tripId);
+}
+
+Trip *RideShareSystem::findRiderActiveTrip(Rider *rider) const
+{
+    return tripStore.getActiveTripForRider(rider);
+}
+
+Trip *RideShareSystem::findDriverActiveTrip(const Driver *driver) const
+{
+    return tripStore.getActiveTripForDriver(driver);
+}
+
+void RideShareSystem::reportDriverLocations(const std::vector<LocationUpdate> &updates)
+{
+    locationIngest.submit(updates);
+}
+
+IngestStats RideShareSystem::applyDriverLocations()
+{
+    SharedLock gate(stateGate);
+    return locationIngest.applyTick();
+}
+
+const DriverStore &RideShareSystem::getDriverStore() const
+{
+    return driverStore;
 }
 
 const std::vector<Rider *> &RideShareSystem::getAllRiders() const
@@ -377,89 +1341,159 @@ void RideShareSystem::displayLocationsByCity(int cityId) const
 void RideShareSystem::displayAvailableDrivers() const
 {
     std::cout << "\n========== AVAILABLE DRIVERS ==========" << std::endl;
-    bool found = false;
-    for (size_t i = 0; i < drivers.size(); ++i)
+    std::vector<Driver *> available = driverStore.getAvailable();
+    for (const Driver *driver : available)
     {
-        const Driver *driver = drivers[i];
-        if (driver->getIsAvailable())
-        {
-            printf(" %d. Driver %s | %s (%s) | %s\n",
-                   (int)(i + 1),
-                   driver->getName().c_str(),
-                   driver->getCarModel().c_str(),
-                   driver->getNumberPlate().c_str(),
-                   driver->getCurrentLocation().c_str());
-            found = true;
-        }
+        printf(" %d. Driver %s | %s (%s) | %s\n",
+               driver->getId() + 1,
+               driver->getName().c_str(),
+               driver->getCarModel().c_str(),
+               driver->getNumberPlate().c_str(),
+               city.getLocationName(driver->getCurrentLocation()).c_str());
     }
 
-    if (!found)
+    if (available.empty())
     {
         std::cout << " [INFO] No drivers available right now.\n";
     }
     std::cout << "======================================\n";
 }
 
-void RideShareSystem::displayAvailableDriversWithETA(const std::string &pickupLocation) const
+void RideShareSystem::displayMemoryUsage() const
 {
-    std::cout << "\n========== AVAILABLE DRIVERS ==========" << std::endl;
-    bool found = false;
-    for (size_t i = 0; i < drivers.size(); ++i)
+    const char *names[3] = {"Drivers", "Riders", "Trips"};
+    PoolStats pools[3] = {driverStore.getMemoryStats(), riderPool.getStats(), tripStore.getMemoryStats()};
+
+    std::cout << "\n========== MEMORY USAGE ==========" << std::endl;
+    for (int i = 0; i < 3; ++i)
     {
-        const Driver *driver = drivers[i];
-        if (driver->getIsAvailable())
+        printf(" %-8s %lu live / %lu slots in %lu slabs | %.1f KB reserved, %.1f KB in use\n",
+               names[i], (unsigned long)pools[i].liveObjects, (unsigned long)pools[i].capacity,
+               (unsigned long)pools[i].slabCount,
+               pools[i].bytesReserved / 1024.0, pools[i].bytesInUse / 1024.0);
+    }
+    printf(" %-8s %lu trips in %.1f KB\n", "Archive", (unsigned long)tripArchive.size(),
+           tripArchive.getMemoryUsage() / 1024.0);
+    std::cout << "==================================\n";
+}
+
+void RideShareSystem::displayDriverStats() const
+{
+    // Finished trips still resident haven't reached the archive's totals yet
+    std::vector<Trip *> finished = tripStore.getInState(COMPLETED);
+    std::vector<Trip *> cancelled = tripStore.getInState(CANCELLED);
+    finished.insert(finished.end(), cancelled.begin(), cancelled.end());
+
+    size_t drivers = driverStore.size();
+    DriverTripStats empty = {0, 0, 0.0};
+    std::vector<DriverTripStats> resident(drivers, empty);
+    for (const Trip *trip : finished)
+    {
+        const Driver *driver = trip->getDriver();
+        if (!driver || (size_t)driver->getId() >= drivers)
+        {
+            continue;
+        }
+        DriverTripStats &stats = resident[driver->getId()];
+        if (trip->getStatus() == COMPLETED)
         {
-            // Calculate distance from driver's current location to pickup location
-            int distance = city.getShortestDistance(driver->getCurrentLocation(), pickupLocation);
+            ++stats.completed;
+            stats.earnings += trip->getFare();
+        }
+        else
+        {
+            ++stats.cancelled;
+        }
+    }
 
-            // If path not found, skip this driver or mark as unavailable
-            if (distance == INT_MAX || distance < 0)
-            {
-                printf(" %d. Driver %s (Unavailable) | %s (%s) | %s\n",
-                       (int)(i + 1),
-                       driver->getName().c_str(),
-                       driver->getCarModel().c_str(),
-                       driver->getNumberPlate().c_str(),
-                       driver->getCurrentLocation().c_str());
-            }
-            else
-            {
-                // Calculate ETA: distance in km / 40 km/h * 60 minutes
-                int etaMinutes = (distance / 40.0) * 60;
-                printf(" %d. Driver %s (%d mins away) | %s (%s) | %s\n",
-                       (int)(i + 1),
-                       driver->getName().c_str(),
-                       etaMinutes,
-                       driver->getCarModel().c_str(),
-                       driver->getNumberPlate().c_str(),
-                       driver->getCurrentLocation().c_str());
-            }
-            found = true;
+    std::cout << "\n============ DRIVER STATS ============" << std::endl;
+    for (size_t id = 0; id < drivers; ++id)
+    {
+        const Driver *driver = driverStore.get((int)id);
+        DriverTripStats stats = tripArchive.getDriverStats((int)id);
+        stats.completed += resident[id].completed;
+        stats.cancelled += resident[id].cancelled;
+        stats.earnings += resident[id].earnings;
+
+        const Trip *active = tripStore.getActiveTripForDriver(driver);
+        std::string status = driver->getIsAvailable() ? "Available" : "Busy";
+        if (active)
+        {
+            status = "Trip #" + std::to_string(active->getId()) + " (" + active->getStateString() + ")";
         }
+
+        printf(" %lu. Driver %s | %lu completed, %lu cancelled | PKR %.2f earned | %s\n",
+               (unsigned long)(id + 1),
+               driver->getName().c_str(),
+               (unsigned long)stats.completed,
+               (unsigned long)stats.cancelled,
+               stats.earnings,
+               status.c_str());
+    }
+
+    if (drivers == 0)
+    {
+        std::cout << " [INFO] No drivers registered.\n";
     }
+    std::cout << "======================================\n";
+}
+
+void RideShareSystem::displayAvailableDriversWithETA(const std::string &pickupLocation, size_t maxDrivers) const
+{
+    displayAvailableDriversWithETA(city.findNodeByName(pickupLocation), maxDrivers);
+}
+
+void RideShareSystem::displayAvailableDriversWithETA(int pickup, size_t maxDrivers) const
+{
+    std::cout << "\n========== AVAILABLE DRIVERS ==========" << std::endl;
 
-    if (!found)
+    // Only the closest few matter here, so search outward instead of
+    // routing every driver in the fleet to the pickup
+    std::vector<DriverCandidate> nearest = getNearestDrivers(pickup, maxDrivers);
+    for (const DriverCandidate &candidate : nearest)
+    {
+        const Driver *driver = candidate.driver;
+
+        // Calculate ETA: distance in km / 40 km/h * 60 minutes
+        int etaMinutes = (candidate.distance / 40.0) * 60;
+        printf(" %d. Driver %s (%d mins away) | %s (%s) | %s\n",
+               driver->getId() + 1,
+               driver->getName().c_str(),
+               etaMinutes,
+               driver->getCarModel().c_str(),
+               driver->getNumberPlate().c_str(),
+               city.getLocationName(driver->getCurrentLocation()).c_str());
+    }
+
+    if (nearest.empty())
     {
         std::cout << " [INFO] No drivers available right now.\n";
     }
     std::cout << "======================================\n";
 }
 
+std::vector<DriverCandidate> RideShareSystem::getNearestDrivers(const std::string &pickupLocation, size_t k, int maxRadius) const
+{
+    return getNearestDrivers(city.findNodeByName(pickupLocation), k, maxRadius);
+}
+
+std::vector<DriverCandidate> RideShareSystem::getNearestDrivers(int pickup, size_t k, int maxRadius) const
+{
+    if (pickup < 0 || pickup >= (int)city.getAllNodes().size())
+    {
+        std::cerr << "Error: Pickup location not found\n";
+        return std::vector<DriverCandidate>();
+    }
+    return dispatchEngine.findNearestDrivers(city, driverIndex, pickup, k, maxRadius);
+}
+
 Driver *RideShareSystem::getDriverById(int driverId) const
 {
-    int count = 0;
-    for (Driver *driver : drivers)
+    if (driverId < 1)
     {
-        if (driver->getIsAvailable())
-        {
-            count++;
-            if (count == driverId)
-            {
-                return driver;
-            }
-        }
+        return nullptr;
     }
-    return nullptr;
+    return driverStore.getNthAvailable((size_t)driverId - 1);
 }
 
 std::string RideShareSystem::getLocationById(int cityId, int locationId) const
@@ -473,3 +1507,16 @@ std::string RideShareSystem::getLocationById(int cityId, int locationId) const
     }
     return "";
 }
+
+int RideShareSystem::getLocationNodeById(int cityId, int locationId) const
+{
+    std::string name = getLocationById(cityId, locationId);
+    if (name.empty())
+    {
+        return -1;
+    }
+    // setupPakistaniCities registers each city's locations in the zone
+    // numbered like the city
+    int nodeId = city.findNodeByName(name, cityId);
+    return nodeId != -1 ? nodeId : city.findNodeByName(name);
+}
@@ -3,20 +3,28 @@
 
 #include <vector>
 #include <string>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <memory>
 #include "City.h"
 #include "DispatchEngine.h"
+#include "DriverStore.h"
+#include "DriverIndex.h"
+#include "LocationIngest.h"
+#include "PendingRequestQueue.h"
 #include "RollbackManager.h"
+#include "ObjectPool.h"
+#include "Rider.h"
+#include "Trip.h"
+#include "TripStore.h"
+#include "TripArchive.h"
+#include "EventLog.h"
+#include "Snapshot.h"
+#include "SharedMutex.h"
 
 class Driver;
-class Rider;
-class Trip;
-
-struct CityInfo
-{
-    int cityId;
-    std::string cityName;
-    std::vector<std::string> locations;
-};
 
 class RideShareSystem
 {
@@ -24,13 +32,75 @@ private:
     City city;
     DispatchEngine dispatchEngine;
     RollbackManager rollbackManager;
-    std::vector<Driver *> drivers;
+    DriverStore driverStore; // The fleet, field by field
+    DriverIndex driverIndex; // Available drivers by node and zone
+    LocationIngest locationIngest; // Batched position reports from devices
+    // Riders are carved from slabs; the list below points into them
+    ObjectPool<Rider> riderPool;
+    TripStore tripStore; // Resident trips, with the live ones indexed by state, rider and driver
+    TripArchive tripArchive; // Finished trips moved out of tripStore
+    // Guards the riders list; bookings append from any thread
+    mutable std::mutex registryMutex;
     std::vector<Rider *> riders;
-    std::vector<Trip *> trips;
     std::vector<CityInfo> cities;
-    int nextDriverId;
-    int nextRiderId;
-    int nextTripId;
+    std::atomic<int> nextRiderId;
+
+    // Batch dispatch: requests wait up to batchWindowMs and are then
+    // assigned together so the batch's total pickup cost is minimal
+    std::atomic<bool> batchDispatch;
+    int batchWindowMs;
+    mutable std::mutex batchMutex; // Guards pendingBatch and batchOpenedAt
+    std::vector<Trip *> pendingBatch;
+    std::chrono::steady_clock::time_point batchOpenedAt; // Arrival of the oldest pending request
+
+    // Requests no driver could take yet; matched as drivers become free
+    PendingRequestQueue waitingRequests;
+
+    // Write-ahead log of every state change, replayed on startup
+    EventLog eventLog;
+    // Held shared by each change together with its log entry, and
+    // exclusively while a snapshot copies the state and rolls the log
+    SharedMutex stateGate;
+    bool replaying; // Replayed changes are not logged again
+    unsigned logSegment; // First log segment not covered by the loaded snapshot
+
+    // Snapshots: state is copied with no change in flight, then written on
+    // a background thread; once written, the log segments it covers are deleted
+    std::string snapshotPath;
+    size_t snapshotEvery; // Logged events between automatic snapshots, 0 for none
+    size_t eventsAtSnapshot;
+    std::thread snapshotWriter;
+    std::atomic<bool> snapshotBusy;
+
+    // Queue a change for the log; commitEvents() waits until it is durable
+    void logEvent(const LogEvent &event);
+    void commitEvents();
+    // Push the trip's state on the undo stack, and log that it happened
+    void recordUndo(Trip *trip);
+    // Re-apply one logged change without dispatching or printing
+    bool replayEvent(const LogEvent &event);
+    // Put REQUESTED trips without a driver that aren't waiting yet (batched
+    // ones, or ones from a snapshot) in the waiting queue, in ID order
+    void queueUnmatchedRequests();
+    void captureSnapshot(SystemSnapshot &snapshot) const;
+    void writeSnapshotAsync(const std::shared_ptr<SystemSnapshot> &snapshot);
+
+    // Rider by ID, nullptr if unknown
+    Rider *findRiderById(int riderId) const;
+    void printTripRow(const TripRecord &record) const;
+
+    // Find the nearest available driver and claim them, retrying if another
+    // booking claims them first; nullptr if nobody is available
+    Driver *reserveNearestDriver(int pickup);
+    // Put a driver at a node, in that node's zone
+    void moveDriver(Driver *driver, int node);
+    // Book an already reserved driver for a trip
+    void assignDriver(Trip *trip, Driver *driver, bool manual);
+    size_t dispatchBatch(const std::vector<Trip *> &queued);
+    // Park a request nobody could take until a driver frees up
+    void waitForDriver(Trip *trip);
+    // Offer a newly freed driver to the waiting request they suit best
+    void redispatchReleasedDriver(Driver *driver);
 
 public:
     RideShareSystem();
@@ -40,6 +110,12 @@ public:
     void addLocation(const std::string &name, int zoneID);
     void addRoad(const std::string &locationA, const std::string &locationB, int distance);
 
+    // Routing configuration
+    void setRoutingMode(RoutingMode mode);
+    // Load the hierarchy index from indexPath, or build it and save it there
+    // if the file is missing or belongs to a different road network
+    bool loadOrBuildContractionHierarchy(const std::string &indexPath);
+
     // Driver operations
     Driver *addDriver(const std::string &name, const std::string &carModel,
                       const std::string &numberPlate, const std::string &location, int zoneID);
@@ -47,35 +123,111 @@ public:
 
     // Rider operations
     Rider *addRider(const std::string &name, const std::string &location);
+    Rider *addRider(const std::string &name, int location);
 
     // Trip operations
+    // requestTrip may be called from many threads at once: routing runs in
+    // parallel and drivers are claimed atomically, so no driver is booked
+    // twice. Changes to the same trip (and undo) take turns. A request whose
+    // driver (picked or nearest) can't be had waits for the next free one.
     Trip *requestTrip(Rider *rider, const std::string &pickup, const std::string &dropoff, Driver *manualDriver = nullptr);
+    Trip *requestTrip(Rider *rider, int pickup, int dropoff, Driver *manualDriver = nullptr);
+    // Refused for a trip still waiting for a driver
     bool completeTrip(Trip *trip);
     bool cancelTrip(Trip *trip);
     bool undoLastAction();
 
+    // Batch dispatch
+    void enableBatchDispatch(int windowMs);
+    // Dispatch anything still pending and go back to one-at-a-time assignment
+    void disableBatchDispatch();
+    bool isBatchDispatchEnabled() const;
+    // Flush the batch if its window has run out; call from the request loop
+    void pollDispatchBatch();
+    // Assign drivers to every pending request now; returns how many got one
+    size_t flushDispatchBatch();
+    size_t getPendingBatchSize() const;
+
+    // Driver location feed: queue reports from any thread, then apply them
+    // once per tick (newest report per driver wins, late ones are dropped)
+    void reportDriverLocations(const std::vector<LocationUpdate> &updates);
+    IngestStats applyDriverLocations();
+
+    // Event log: replay the changes already in path, then log every new
+    // one there. Bookings, completions, cancellations and undos return only
+    // once their changes are on disk; concurrent callers share each fsync.
+    // Requests that were waiting (or batched) when the process stopped go
+    // back to waiting for a free driver.
+    bool openEventLog(const std::string &path);
+    LogStats getEventLogStats() const;
+
+    // Snapshots for fast restart. Call loadSnapshot() on an empty system,
+    // before openEventLog(), so only the log written since is replayed.
+    // takeSnapshot() waits for changes in flight, copies the state and
+    // starts a new log segment in one step (new changes wait meanwhile), and
+    // returns while the copy is written. pollSnapshot() takes one every
+    // everyEvents logged events.
+    void enableSnapshots(const std::string &path, size_t everyEvents);
+    bool loadSnapshot();
+    bool takeSnapshot();
+    void pollSnapshot();
+    // Block until a snapshot being written is finished
+    void waitForSnapshot();
+
+    // Requests still waiting for a driver, longest wait first
+    std::vector<Trip *> getWaitingRequests() const;
+
     // Pakistani Cities Setup
     void setupPakistaniCities();
     void displayCities() const;
     void displayLocationsByCity(int cityId) const;
     void displayAvailableDrivers() const;
-    void displayAvailableDriversWithETA(const std::string &pickupLocation) const;
+    // Slab memory held for drivers, riders and trips, and the trip archive
+    void displayMemoryUsage() const;
+    // Lists the maxDrivers cheapest drivers for the pickup, best first, each
+    // numbered by registration order (the number main uses to pick one)
+    void displayAvailableDriversWithETA(const std::string &pickupLocation, size_t maxDrivers = 10) const;
+    void displayAvailableDriversWithETA(int pickup, size_t maxDrivers = 10) const;
+    // Up to k available drivers within maxRadius of the pickup, cheapest first
+    std::vector<DriverCandidate> getNearestDrivers(const std::string &pickupLocation, size_t k,
+                                                   int maxRadius = INT_MAX) const;
+    std::vector<DriverCandidate> getNearestDrivers(int pickup, size_t k, int maxRadius = INT_MAX) const;
     Driver *getDriverById(int driverId) const;
     std::string getLocationById(int cityId, int locationId) const;
+    // Node ID of a menu entry, -1 if invalid; names shared by several cities
+    // resolve to the node in that city's zone
+    int getLocationNodeById(int cityId, int locationId) const;
+
+    // Move finished trips that no undo entry or pending batch still refers
+    // to into the archive, freeing their Trip objects; returns how many moved.
+    // Pointers to archived trips dangle, so call this between requests.
+    size_t archiveFinishedTrips();
+    // Resident and archived trips in ID order, as the trip status table
+    void displayTripHistory() const;
+    // Trips ever booked, archived ones included
+    size_t getTripCount() const;
+    const TripArchive &getTripArchive() const;
 
     // Getter methods
-    const std::vector<Trip *> &getAllTrips() const;
-    const std::vector<Driver *> &getAllDrivers() const;
+    // Resident trips in ID order; archived ones are in getTripArchive()
+    std::vector<Trip *> getAllTrips() const;
+    // REQUESTED, ASSIGNED and ONGOING trips in ID order, without scanning history
+    std::vector<Trip *> getActiveTrips() const;
+    Trip *getTripById(int tripId) const;
+    const DriverStore &getDriverStore() const;
     const std::vector<Rider *> &getAllRiders() const;
     const std::vector<CityInfo> &getAllCities() const;
 
     // Display helper methods
     void displayAllLocations() const;
     void displayAllRiders() const;
+    // Completed and cancelled trips and earnings per driver, archive included
     void displayDriverStats() const;
 
-    // Utility method
+    // Utility method: the rider's newest REQUESTED/ASSIGNED/ONGOING trip, O(1)
     Trip *findRiderActiveTrip(Rider *rider) const;
+    // The trip the driver is serving, nullptr if none, O(1)
+    Trip *findDriverActiveTrip(const Driver *driver) const;
 };
 
 #endif // RIDESHARESYSTEM_H
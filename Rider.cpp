@@ -1,6 +1,6 @@
 #include "Rider.h"
 
-Rider::Rider(int id, const std::string &name, const std::string &location)
+Rider::Rider(int id, const std::string &name, int location)
     : id(id), name(name), location(location) {}
 
 int Rider::getId() const
@@ -13,12 +13,12 @@ const std::string &Rider::getName() const
     return name;
 }
 
-const std::string &Rider::getLocation() const
+int Rider::getLocation() const
 {
     return location;
 }
 
-void Rider::setLocation(const std::string &newLocation)
+void Rider::setLocation(int newLocation)
 {
     location = newLocation;
 }
@@ -8,16 +8,16 @@ class Rider
 private:
     int id;
     std::string name;
-    std::string location;
+    int location; // City node ID
 
 public:
-    Rider(int id, const std::string &name, const std::string &location);
+    Rider(int id, const std::string &name, int location);
 
     int getId() const;
     const std::string &getName() const;
-    const std::string &getLocation() const;
+    int getLocation() const;
 
-    void setLocation(const std::string &newLocation);
+    void setLocation(int newLocation);
 };
 
 #endif // RIDER_H
@@ -3,9 +3,29 @@
 #include "Driver.h"
 #include <iostream>
 
-RollbackManager::RollbackManager() {}
+RollbackManager::RollbackManager() : maxDepth(DEFAULT_MAX_DEPTH) {}
 
-void RollbackManager::recordState(Trip *trip)
+void RollbackManager::release(const Trip *trip)
+{
+    std::unordered_map<const Trip *, int>::iterator found = references.find(trip);
+    if (found != references.end() && --found->second == 0)
+    {
+        references.erase(found);
+    }
+}
+
+void RollbackManager::setMaxDepth(size_t depth)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    maxDepth = depth;
+    while (actionStack.size() > maxDepth)
+    {
+        release(actionStack.front().trip);
+        actionStack.pop_front();
+    }
+}
+
+void RollbackManager::recordState(Trip *trip, const std::function<void(const Trip *)> &logPush)
 {
     if (!trip)
     {
@@ -18,54 +38,157 @@ void RollbackManager::recordState(Trip *trip)
     action.oldState = trip->getStatus();
     action.assignedDriver = trip->getDriver();
 
+    std::lock_guard<std::mutex> lock(mutex);
     actionStack.push_back(action);
+    ++references[trip];
+    if (logPush)
+    {
+        logPush(trip);
+    }
+    if (actionStack.size() > maxDepth)
+    {
+        release(actionStack.front().trip);
+        actionStack.pop_front();
+    }
 }
 
-bool RollbackManager::undoLastOperation()
+bool RollbackManager::undoLastOperation(UndoOutcome *outcome, const std::function<void(const Trip *)> &logPop)
 {
+    std::lock_guard<std::mutex> lock(mutex);
     if (actionStack.empty())
     {
         std::cerr << "Error: Nothing to undo\n";
         return false;
     }
 
-    TripAction lastAction = actionStack.back();
-    actionStack.pop_back();
-
+    const TripAction &lastAction = actionStack.back();
     Trip *trip = lastAction.trip;
+    if (busy.count(trip) != 0)
+    {
+        std::cerr << "Error: Trip #" << trip->getId() << " is being changed; cannot undo it now\n";
+        return false;
+    }
     TripState oldState = lastAction.oldState;
     Driver *assignedDriver = lastAction.assignedDriver;
 
+    // The trip holds its driver only while ASSIGNED or ONGOING; once it
+    // finished, the driver may have been booked again by someone else
+    TripState currentState = trip->getStatus();
+    Driver *currentDriver = trip->getDriver();
+    bool holdsDriver = currentDriver && (currentState == ASSIGNED || currentState == ONGOING);
+    bool restoresDriver = assignedDriver && (oldState == ASSIGNED || oldState == ONGOING);
+
+    // Take the driver back the way bookings do, so an undo can't hand a
+    // driver to a second trip; if they are taken, the entry stays for later
+    if (restoresDriver && !(holdsDriver && currentDriver == assignedDriver) && !assignedDriver->tryReserve())
+    {
+        std::cerr << "Error: Driver " << assignedDriver->getName() << " is on another trip; cannot undo Trip #"
+                  << trip->getId() << "\n";
+        return false;
+    }
+
+    if (logPop)
+    {
+        logPop(trip);
+    }
+    release(trip);
+    actionStack.pop_back();
+
     // Restore the trip state
     trip->setStatus(oldState);
 
     // Handle driver state changes
-    if (oldState == REQUESTED && trip->getDriver() != nullptr)
+    Driver *releasedDriver = nullptr;
+    if (holdsDriver && (!restoresDriver || currentDriver != assignedDriver))
+    {
+        // Reverting from ASSIGNED/ONGOING - free the driver
+        currentDriver->setAvailable(true);
+        releasedDriver = currentDriver;
+    }
+    if (oldState == REQUESTED)
     {
-        // Reverting from ASSIGNED/ONGOING/COMPLETED to REQUESTED - free the driver
-        trip->getDriver()->setAvailable(true);
         trip->setDriver(nullptr);
     }
-    else if (oldState == ASSIGNED && assignedDriver != nullptr)
+    else if (assignedDriver)
     {
-        // Reverting to ASSIGNED state - restore the driver
+        // Reverting to ASSIGNED - restore the assignment (already claimed above);
+        // a finished trip just remembers who drove it
         trip->setDriver(assignedDriver);
-        assignedDriver->setAvailable(false);
     }
-    else if (oldState == CANCELLED)
+
+    if (outcome)
     {
-        // Reverting from CANCELLED - restore the previous driver assignment
-        if (assignedDriver != nullptr)
-        {
-            trip->setDriver(assignedDriver);
-            assignedDriver->setAvailable(false);
-        }
+        outcome->trip = trip;
+        outcome->releasedDriver = releasedDriver;
     }
-
     return true;
 }
 
+void RollbackManager::beginChange(const Trip *trip)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (busy.count(trip) != 0)
+    {
+        changeDone.wait(lock);
+    }
+    busy.insert(trip);
+}
+
+void RollbackManager::endChange(const Trip *trip)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        busy.erase(trip);
+    }
+    changeDone.notify_all();
+}
+
 size_t RollbackManager::getStackSize() const
 {
+    std::lock_guard<std::mutex> lock(mutex);
     return actionStack.size();
 }
+
+const Trip *RollbackManager::getLastTrip() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return actionStack.empty() ? nullptr : actionStack.back().trip;
+}
+
+bool RollbackManager::isReferenced(const Trip *trip) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return references.count(trip) != 0;
+}
+
+std::vector<TripAction> RollbackManager::getActions() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::vector<TripAction>(actionStack.begin(), actionStack.end());
+}
+
+void RollbackManager::restoreActions(const std::vector<TripAction> &actions)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    actionStack.assign(actions.begin(), actions.end());
+    references.clear();
+    for (const TripAction &action : actionStack)
+    {
+        ++references[action.trip];
+    }
+    while (actionStack.size() > maxDepth)
+    {
+        release(actionStack.front().trip);
+        actionStack.pop_front();
+    }
+}
+
+TripChangeGuard::TripChangeGuard(RollbackManager &manager, const Trip *trip) : manager(manager), trip(trip)
+{
+    manager.beginChange(trip);
+}
+
+TripChangeGuard::~TripChangeGuard()
+{
+    manager.endChange(trip);
+}
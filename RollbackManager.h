@@ -3,6 +3,12 @@
 
 #include <vector>
 #include <cstddef>
+#include <mutex>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
+#include <functional>
 #include "Trip.h"
 
 class Driver;
@@ -14,22 +20,83 @@ struct TripAction
     Driver *assignedDriver;
 };
 
+// What a successful undo changed, for the caller to follow up on
+struct UndoOutcome
+{
+    Trip *trip;             // The trip put back
+    Driver *releasedDriver; // Driver the trip let go of, nullptr if none
+};
+
 class RollbackManager
 {
 private:
-    std::vector<TripAction> actionStack;
+    mutable std::mutex mutex; // Bookings on several threads record states concurrently
+    std::deque<TripAction> actionStack; // Oldest first, so the depth cap can drop from the front
+    size_t maxDepth;
+    // Undo entries per trip; a trip with none can be archived
+    std::unordered_map<const Trip *, int> references;
+    // Trips a caller is changing right now; undo leaves them alone and
+    // other changers wait for changeDone
+    std::unordered_set<const Trip *> busy;
+    std::condition_variable changeDone;
+
+    void release(const Trip *trip);
 
 public:
+    // How far back undo reaches by default
+    static const size_t DEFAULT_MAX_DEPTH = 1000;
+
     RollbackManager();
 
-    // Record the current state of a trip before making changes
-    void recordState(Trip *trip);
+    // Keep at most depth actions, forgetting the oldest first
+    void setMaxDepth(size_t depth);
+
+    // Record the current state of a trip before making changes. logPush
+    // (and undo's logPop) run under the stack's lock, so the event log sees
+    // pushes and pops in the order they happened to the stack
+    void recordState(Trip *trip, const std::function<void(const Trip *)> &logPush = nullptr);
 
-    // Undo the last operation
-    bool undoLastOperation();
+    // Undo the last operation. A trip going back to ASSIGNED claims its
+    // driver again with Driver::tryReserve(); if someone else booked them in
+    // the meantime, or the trip is being changed, the undo fails and the
+    // entry stays on the stack. On success, outcome (if given) says which
+    // trip changed and which driver became free. logPop gets the trip just
+    // before its entry is removed.
+    bool undoLastOperation(UndoOutcome *outcome = nullptr,
+                           const std::function<void(const Trip *)> &logPop = nullptr);
+
+    // Bracket a change to a trip (booking, completion, ...) so a concurrent
+    // undo can't rewrite it halfway and other changes to it wait their turn.
+    // Don't nest: finish with one trip before starting on another
+    void beginChange(const Trip *trip);
+    void endChange(const Trip *trip);
 
     // Get the size of the undo stack
     size_t getStackSize() const;
+    // Trip the next undo would change, nullptr if the stack is empty
+    const Trip *getLastTrip() const;
+
+    // The undo stack, oldest first, and a way to put one back (snapshot restore)
+    std::vector<TripAction> getActions() const;
+    void restoreActions(const std::vector<TripAction> &actions);
+
+    // Whether any undo entry still points at the trip
+    bool isReferenced(const Trip *trip) const;
+};
+
+// Holds RollbackManager::beginChange() for a trip until it goes out of scope
+class TripChangeGuard
+{
+private:
+    RollbackManager &manager;
+    const Trip *trip;
+
+    TripChangeGuard(const TripChangeGuard &);
+    TripChangeGuard &operator=(const TripChangeGuard &);
+
+public:
+    TripChangeGuard(RollbackManager &manager, const Trip *trip);
+    ~TripChangeGuard();
 };
 
 #endif // ROLLBACKMANAGER_H
@@ -0,0 +1,58 @@
+#include "SearchWorkspace.h"
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+// Idle workspaces owned by the current thread
+thread_local std::vector<std::unique_ptr<SearchWorkspace>> idleWorkspaces;
+} // namespace
+
+SearchWorkspace::SearchWorkspace() : generation(0) {}
+
+void SearchWorkspace::reset(size_t nodeCount)
+{
+    if (dist.size() < nodeCount)
+    {
+        dist.resize(nodeCount, INT_MAX);
+        stamp.resize(nodeCount, 0);
+    }
+    heap.resize(nodeCount);
+    heap.clear();
+
+    if (++generation == 0)
+    {
+        // Counter wrapped: old stamps could look current again, so wipe them once
+        std::fill(stamp.begin(), stamp.end(), 0);
+        generation = 1;
+    }
+}
+
+SearchWorkspace::Lease::Lease(size_t nodeCount)
+{
+    if (idleWorkspaces.empty())
+    {
+        workspace = new SearchWorkspace();
+    }
+    else
+    {
+        workspace = idleWorkspaces.back().release();
+        idleWorkspaces.pop_back();
+    }
+    workspace->reset(nodeCount);
+}
+
+SearchWorkspace::Lease::~Lease()
+{
+    idleWorkspaces.push_back(std::unique_ptr<SearchWorkspace>(workspace));
+}
+
+SearchWorkspace &SearchWorkspace::Lease::operator*() const
+{
+    return *workspace;
+}
+
+SearchWorkspace *SearchWorkspace::Lease::operator->() const
+{
+    return workspace;
+}
@@ -0,0 +1,70 @@
+#ifndef SEARCHWORKSPACE_H
+#define SEARCHWORKSPACE_H
+
+#include <vector>
+#include <cstddef>
+#include <climits>
+#include "IndexedHeap.h"
+
+// Reusable per-thread scratch space for graph searches.
+// Distances are tagged with a generation number, so starting a new search
+// only bumps the generation instead of refilling a V-sized array; entries
+// from older searches simply read as INT_MAX. Work per query is therefore
+// proportional to the nodes it actually touches.
+class SearchWorkspace
+{
+private:
+    std::vector<int> dist;
+    std::vector<unsigned int> stamp;
+    unsigned int generation;
+    IndexedHeap heap;
+
+    SearchWorkspace(const SearchWorkspace &);
+    SearchWorkspace &operator=(const SearchWorkspace &);
+
+public:
+    SearchWorkspace();
+
+    // Start a new search over nodeCount nodes
+    void reset(size_t nodeCount);
+
+    int getDistance(int node) const;
+    void setDistance(int node, int distance);
+    IndexedHeap &frontier();
+
+    // Borrows a workspace from the calling thread's pool for one search.
+    // Leases nest, so a search may run while another is still in progress.
+    class Lease
+    {
+    private:
+        SearchWorkspace *workspace;
+
+        Lease(const Lease &);
+        Lease &operator=(const Lease &);
+
+    public:
+        explicit Lease(size_t nodeCount);
+        ~Lease();
+
+        SearchWorkspace &operator*() const;
+        SearchWorkspace *operator->() const;
+    };
+};
+
+inline int SearchWorkspace::getDistance(int node) const
+{
+    return stamp[node] == generation ? dist[node] : INT_MAX;
+}
+
+inline void SearchWorkspace::setDistance(int node, int distance)
+{
+    dist[node] = distance;
+    stamp[node] = generation;
+}
+
+inline IndexedHeap &SearchWorkspace::frontier()
+{
+    return heap;
+}
+
+#endif // SEARCHWORKSPACE_H
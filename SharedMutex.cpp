@@ -0,0 +1,58 @@
+#include "SharedMutex.h"
+
+SharedMutex::SharedMutex() : readers(0), waitingWriters(0), writer(false) {}
+
+void SharedMutex::lock()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    ++waitingWriters;
+    while (writer || readers > 0)
+    {
+        changed.wait(lock);
+    }
+    --waitingWriters;
+    writer = true;
+}
+
+void SharedMutex::unlock()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        writer = false;
+    }
+    changed.notify_all();
+}
+
+void SharedMutex::lockShared()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    // Queued writers go first
+    while (writer || waitingWriters > 0)
+    {
+        changed.wait(lock);
+    }
+    ++readers;
+}
+
+void SharedMutex::unlockShared()
+{
+    bool last;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        last = --readers == 0;
+    }
+    if (last)
+    {
+        changed.notify_all();
+    }
+}
+
+SharedLock::SharedLock(SharedMutex &shared) : shared(shared)
+{
+    shared.lockShared();
+}
+
+SharedLock::~SharedLock()
+{
+    shared.unlockShared();
+}
@@ -0,0 +1,48 @@
+#ifndef SHAREDMUTEX_H
+#define SHAREDMUTEX_H
+
+#include <cstddef>
+#include <mutex>
+#include <condition_variable>
+
+// Reader-writer lock (std::shared_mutex needs C++17).
+// Any number of threads may hold it shared; lock() waits for them to leave
+// and holds newcomers back meanwhile, so a writer is never starved. Not
+// recursive: a thread holding it shared must not take it again.
+// lock()/unlock() suit std::lock_guard; SharedLock holds it shared.
+class SharedMutex
+{
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t readers;
+    size_t waitingWriters;
+    bool writer;
+
+    SharedMutex(const SharedMutex &);
+    SharedMutex &operator=(const SharedMutex &);
+
+public:
+    SharedMutex();
+
+    void lock();
+    void unlock();
+    void lockShared();
+    void unlockShared();
+};
+
+// Holds a SharedMutex shared until it goes out of scope
+class SharedLock
+{
+private:
+    SharedMutex &shared;
+
+    SharedLock(const SharedLock &);
+    SharedLock &operator=(const SharedLock &);
+
+public:
+    explicit SharedLock(SharedMutex &shared);
+    ~SharedLock();
+};
+
+#endif // SHAREDMUTEX_H
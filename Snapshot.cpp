@@ -0,0 +1,389 @@
+#include "Snapshot.h"
+#include "BinaryIO.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+using namespace binaryio;
+
+namespace
+{
+const char FILE_MAGIC[4] = {'R', 'S', 'S', 'N'};
+// Version 2 stores sealed archive segments as encoded; version 1 files
+// (every archived trip as a plain record) are still read
+const int FILE_VERSION = 2;
+const size_t HEADER_SIZE = sizeof(FILE_MAGIC) + sizeof(FILE_VERSION);
+
+void putTrip(std::vector<char> &out, const TripRecord &trip)
+{
+    put<int>(out, trip.tripId);
+    put<int>(out, trip.riderId);
+    put<int>(out, trip.driverId);
+    put<int>(out, trip.pickup);
+    put<int>(out, trip.dropoff);
+    put<int>(out, trip.state);
+    put<double>(out, trip.fare);
+    put<long long>(out, trip.requestedAt);
+    put<long long>(out, trip.finishedAt);
+}
+
+bool getTrip(const char *data, size_t size, size_t &pos, TripRecord &trip)
+{
+    int state = 0;
+    bool ok = get(data, size, pos, trip.tripId) &&
+              get(data, size, pos, trip.riderId) &&
+              get(data, size, pos, trip.driverId) &&
+              get(data, size, pos, trip.pickup) &&
+              get(data, size, pos, trip.dropoff) &&
+              get(data, size, pos, state) &&
+              get(data, size, pos, trip.fare) &&
+              get(data, size, pos, trip.requestedAt) &&
+              get(data, size, pos, trip.finishedAt);
+    trip.state = (TripState)state;
+    return ok;
+}
+
+// Element count of the next list, rejecting counts the remaining bytes can't hold
+bool getCount(const char *data, size_t size, size_t &pos, std::uint32_t &count)
+{
+    return get(data, size, pos, count) && count <= size - pos;
+}
+
+void putSegment(std::vector<char> &out, const TripArchive::Segment &segment)
+{
+    put<std::uint32_t>(out, (std::uint32_t)segment.count);
+    put<int>(out, segment.minTripId);
+    put<int>(out, segment.maxTripId);
+    for (int column = 0; column < TripArchive::COLUMN_COUNT; ++column)
+    {
+        const std::vector<std::uint8_t> &bytes = segment.columns[column];
+        put<std::uint32_t>(out, (std::uint32_t)bytes.size());
+        out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+}
+
+// The columns are checked when the archive is restored, not here
+bool getSegment(const char *data, size_t size, size_t &pos, TripArchive::Segment &segment)
+{
+    std::uint32_t count = 0;
+    if (!get(data, size, pos, count) || !get(data, size, pos, segment.minTripId) ||
+        !get(data, size, pos, segment.maxTripId))
+    {
+        return false;
+    }
+    segment.count = count;
+    for (int column = 0; column < TripArchive::COLUMN_COUNT; ++column)
+    {
+        std::uint32_t length = 0;
+        if (!getCount(data, size, pos, length))
+        {
+            return false;
+        }
+        segment.columns[column].assign(data + pos, data + pos + length);
+        pos += length;
+    }
+    return true;
+}
+
+void encode(const SystemSnapshot &snapshot, std::vector<char> &out)
+{
+    put<unsigned>(out, snapshot.logSegment);
+
+    put<std::uint32_t>(out, (std::uint32_t)snapshot.locations.size());
+    for (const Node &node : snapshot.locations)
+    {
+        putString(out, node.name);
+        put<int>(out, node.zoneID);
+    }
+
+    put<std::uint32_t>(out, (std::uint32_t)snapshot.roads.size());
+    for (const RoadRecord &road : snapshot.roads)
+    {
+        put<int>(out, road.from);
+        put<int>(out, road.to);
+        put<int>(out, road.distance);
+    }
+
+    put<std::uint32_t>(out, (std::uint32_t)snapshot.cities.size());
+    for (const CityInfo &info : snapshot.cities)
+    {
+        put<int>(out, info.cityId);
+        putString(out, info.cityName);
+        put<std::uint32_t>(out, (std::uint32_t)info.locations.size());
+        for (const std::string &location : info.locations)
+        {
+            putString(out, location);
+        }
+    }
+
+    put<std::uint32_t>(out, (std::uint32_t)snapshot.drivers.size());
+    for (const DriverRecord &driver : snapshot.drivers)
+    {
+        putString(out, driver.name);
+        putString(out, driver.carModel);
+        putString(out, driver.numberPlate);
+        put<int>(out, driver.location);
+        put<int>(out, driver.zone);
+        put<char>(out, driver.available ? 1 : 0);
+    }
+
+    put<std::uint32_t>(out, (std::uint32_t)snapshot.riders.size());
+    for (const RiderRecord &rider : snapshot.riders)
+    {
+        put<int>(out, rider.id);
+        putString(out, rider.name);
+        put<int>(out, rider.location);
+    }
+
+    put<int>(out, snapshot.nextTripId);
+    put<std::uint32_t>(out, (std::uint32_t)snapshot.trips.size());
+    for (const TripRecord &trip : snapshot.trips)
+    {
+        putTrip(out, trip);
+    }
+    put<std::uint32_t>(out, (std::uint32_t)snapshot.archivedSegments.size());
+    for (const std::shared_ptr<const TripArchive::Segment> &segment : snapshot.archivedSegments)
+    {
+        putSegment(out, *segment);
+    }
+    put<std::uint32_t>(out, (std::uint32_t)snapshot.archived.size());
+    for (const TripRecord &trip : snapshot.archived)
+    {
+        putTrip(out, trip);
+    }
+
+    put<std::uint32_t>(out, (std::uint32_t)snapshot.undo.size());
+    for (const UndoRecord &action : snapshot.undo)
+    {
+        put<int>(out, action.tripId);
+        put<int>(out, action.oldState);
+        put<int>(out, action.driverId);
+    }
+}
+
+bool decode(const char *data, size_t size, int version, SystemSnapshot &snapshot)
+{
+    size_t pos = 0;
+    std::uint32_t count = 0;
+    if (!get(data, size, pos, snapshot.logSegment) || !getCount(data, size, pos, count))
+    {
+        return false;
+    }
+    snapshot.locations.resize(count);
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        Node &node = snapshot.locations[i];
+        node.id = (int)i;
+        if (!getString(data, size, pos, node.name) || !get(data, size, pos, node.zoneID))
+        {
+            return false;
+        }
+    }
+
+    if (!getCount(data, size, pos, count))
+    {
+        return false;
+    }
+    snapshot.roads.resize(count);
+    for (RoadRecord &road : snapshot.roads)
+    {
+        if (!get(data, size, pos, road.from) || !get(data, size, pos, road.to) || !get(data, size, pos, road.distance))
+        {
+            return false;
+        }
+    }
+
+    if (!getCount(data, size, pos, count))
+    {
+        return false;
+    }
+    snapshot.cities.resize(count);
+    for (CityInfo &info : snapshot.cities)
+    {
+        std::uint32_t locations = 0;
+        if (!get(data, size, pos, info.cityId) || !getString(data, size, pos, info.cityName) ||
+            !getCount(data, size, pos, locations))
+        {
+            return false;
+        }
+        info.locations.resize(locations);
+        for (std::string &location : info.locations)
+        {
+            if (!getString(data, size, pos, location))
+            {
+                return false;
+            }
+        }
+    }
+
+    if (!getCount(data, size, pos, count))
+    {
+        return false;
+    }
+    snapshot.drivers.resize(count);
+    for (DriverRecord &driver : snapshot.drivers)
+    {
+        char available = 0;
+        if (!getString(data, size, pos, driver.name) || !getString(data, size, pos, driver.carModel) ||
+            !getString(data, size, pos, driver.numberPlate) || !get(data, size, pos, driver.location) ||
+            !get(data, size, pos, driver.zone) || !get(data, size, pos, available))
+        {
+            return false;
+        }
+        driver.available = available != 0;
+    }
+
+    if (!getCount(data, size, pos, count))
+    {
+        return false;
+    }
+    snapshot.riders.resize(count);
+    for (RiderRecord &rider : snapshot.riders)
+    {
+        if (!get(data, size, pos, rider.id) || !getString(data, size, pos, rider.name) ||
+            !get(data, size, pos, rider.location))
+        {
+            return false;
+        }
+    }
+
+    if (!get(data, size, pos, snapshot.nextTripId) || !getCount(data, size, pos, count))
+    {
+        return false;
+    }
+    snapshot.trips.resize(count);
+    for (TripRecord &trip : snapshot.trips)
+    {
+        if (!getTrip(data, size, pos, trip))
+        {
+            return false;
+        }
+    }
+    snapshot.archivedSegments.clear();
+    if (version >= 2)
+    {
+        if (!getCount(data, size, pos, count))
+        {
+            return false;
+        }
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            std::shared_ptr<TripArchive::Segment> segment(new TripArchive::Segment());
+            if (!getSegment(data, size, pos, *segment))
+            {
+                return false;
+            }
+            snapshot.archivedSegments.push_back(segment);
+        }
+    }
+    if (!getCount(data, size, pos, count))
+    {
+        return false;
+    }
+    snapshot.archived.resize(count);
+    for (TripRecord &trip : snapshot.archived)
+    {
+        if (!getTrip(data, size, pos, trip))
+        {
+            return false;
+        }
+    }
+
+    if (!getCount(data, size, pos, count))
+    {
+        return false;
+    }
+    snapshot.undo.resize(count);
+    for (UndoRecord &action : snapshot.undo)
+    {
+        int state = 0;
+        if (!get(data, size, pos, action.tripId) || !get(data, size, pos, state) ||
+            !get(data, size, pos, action.driverId))
+        {
+            return false;
+        }
+        action.oldState = (TripState)state;
+    }
+    return pos == size;
+}
+} // namespace
+
+bool writeSnapshot(const std::string &path, const SystemSnapshot &snapshot)
+{
+    std::vector<char> body;
+    encode(snapshot, body);
+
+    std::vector<char> header(FILE_MAGIC, FILE_MAGIC + sizeof(FILE_MAGIC));
+    put<int>(header, FILE_VERSION);
+    std::vector<char> trailer;
+    put<std::uint32_t>(trailer, checksum(body.data(), body.size()));
+
+    std::string temporary = path + ".tmp";
+    std::FILE *out = std::fopen(temporary.c_str(), "wb");
+    bool ok = out && std::fwrite(&header[0], 1, header.size(), out) == header.size() &&
+              std::fwrite(body.data(), 1, body.size(), out) == body.size() &&
+              std::fwrite(&trailer[0], 1, trailer.size(), out) == trailer.size() &&
+              syncFile(out);
+    if (out)
+    {
+        std::fclose(out);
+    }
+    // The caller deletes the log segments this snapshot covers once it
+    // returns, so the rename itself must be on disk by then
+#if defined(_WIN32)
+    ok = ok && MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    ok = ok && std::rename(temporary.c_str(), path.c_str()) == 0 && syncDirectoryOf(path);
+#endif
+    if (!ok)
+    {
+        std::cerr << "Error: Cannot write snapshot " << path << "\n";
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool readSnapshot(const std::string &path, SystemSnapshot &snapshot)
+{
+    std::vector<char> contents;
+    {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        if (!in)
+        {
+            return false;
+        }
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    size_t pos = sizeof(FILE_MAGIC);
+    int version = 0;
+    if (contents.size() < HEADER_SIZE + sizeof(std::uint32_t) ||
+        !std::equal(FILE_MAGIC, FILE_MAGIC + sizeof(FILE_MAGIC), contents.begin()) ||
+        !get(&contents[0], contents.size(), pos, version) || version < 1 || version > FILE_VERSION)
+    {
+        std::cerr << "Error: " << path << " is not a snapshot\n";
+        return false;
+    }
+
+    const char *body = &contents[0] + HEADER_SIZE;
+    size_t bodySize = contents.size() - HEADER_SIZE - sizeof(std::uint32_t);
+    std::uint32_t expected = 0;
+    size_t trailerPos = HEADER_SIZE + bodySize;
+    get(&contents[0], contents.size(), trailerPos, expected);
+    if (checksum(body, bodySize) != expected || !decode(body, bodySize, version, snapshot))
+    {
+        std::cerr << "Error: Snapshot " << path << " is damaged\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include "City.h"
+#include "Trip.h"
+#include "TripArchive.h"
+
+struct RoadRecord
+{
+    int from; // City node IDs
+    int to;
+    int distance;
+};
+
+struct DriverRecord
+{
+    std::string name;
+    std::string carModel;
+    std::string numberPlate;
+    int location;
+    int zone;
+    bool available;
+};
+
+struct RiderRecord
+{
+    int id;
+    std::string name;
+    int location;
+};
+
+// One undo stack entry
+struct UndoRecord
+{
+    int tripId;
+    TripState oldState;
+    int driverId; // -1 if none
+};
+
+// Complete system state at one point in the event log; restoring it and
+// replaying the segments from logSegment on rebuilds the system.
+// Drivers are listed by ID; trips resident and archived keep their IDs.
+struct SystemSnapshot
+{
+    unsigned logSegment; // First log segment not covered
+    std::vector<Node> locations; // By node ID
+    std::vector<RoadRecord> roads;
+    std::vector<CityInfo> cities;
+    std::vector<DriverRecord> drivers;
+    std::vector<RiderRecord> riders;
+    int nextTripId;
+    std::vector<TripRecord> trips;    // Resident
+    // Archived trips as the archive keeps them: its sealed segments, shared
+    // with it and still encoded, then the records not sealed yet
+    std::vector<std::shared_ptr<const TripArchive::Segment>> archivedSegments;
+    std::vector<TripRecord> archived;
+    std::vector<UndoRecord> undo;     // Oldest first
+};
+
+// Write to a temporary file, fsync it and rename it over path, so a crash
+// leaves either the old snapshot or the new one; returns true only once the
+// rename is durable too
+bool writeSnapshot(const std::string &path, const SystemSnapshot &snapshot);
+// False if path is missing (silently) or damaged (with an error)
+bool readSnapshot(const std::string &path, SystemSnapshot &snapshot);
+
+#endif // SNAPSHOT_H
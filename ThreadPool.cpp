@@ -0,0 +1,171 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace
+{
+// Pool and queue of the worker running on this thread, if any
+thread_local ThreadPool *currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+// Chunks handed out per thread, so stealing can even out uneven work
+const size_t CHUNKS_PER_THREAD = 4;
+} // namespace
+
+ThreadPool::ThreadPool(size_t threadCount) : queuedCount(0), nextQueue(0), stopping(false)
+{
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+ThreadPool &ThreadPool::shared()
+{
+    static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return pool;
+}
+
+size_t ThreadPool::getThreadCount() const
+{
+    return workers.size();
+}
+
+void ThreadPool::push(std::function<void()> task)
+{
+    // Workers keep their own tasks local; outside callers spread them round-robin
+    size_t target = currentPool == this ? currentWorker : nextQueue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    {
+        // Counted under the sleep lock so a worker about to wait cannot miss it
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++queuedCount;
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::runOne()
+{
+    size_t queueCount = queues.size();
+    if (queueCount == 0)
+    {
+        return false;
+    }
+
+    std::function<void()> task;
+    bool isWorker = currentPool == this;
+    size_t self = isWorker ? currentWorker : 0;
+
+    if (isWorker)
+    {
+        // Newest own task first: its data is most likely still in cache
+        WorkQueue &own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+
+    for (size_t k = isWorker ? 1 : 0; !task && k < queueCount; ++k)
+    {
+        // Steal the oldest task, which tends to be the largest piece left
+        WorkQueue &victim = *queues[(self + k) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (!task)
+    {
+        return false;
+    }
+    --queuedCount;
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+    currentPool = this;
+    currentWorker = index;
+
+    while (true)
+    {
+        if (runOne())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stopping || queuedCount > 0; });
+        if (stopping && queuedCount == 0)
+        {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain,
+                             const std::function<void(size_t, size_t)> &body)
+{
+    if (end <= begin)
+    {
+        return;
+    }
+
+    size_t count = end - begin;
+    size_t pieces = (queues.size() + 1) * CHUNKS_PER_THREAD;
+    size_t chunk = std::max(std::max<size_t>(grain, 1), (count + pieces - 1) / pieces);
+    if (queues.empty() || count <= chunk)
+    {
+        body(begin, end);
+        return;
+    }
+
+    size_t chunkCount = (count + chunk - 1) / chunk;
+    std::atomic<size_t> pending(chunkCount - 1);
+    for (size_t c = 1; c < chunkCount; ++c)
+    {
+        size_t low = begin + c * chunk;
+        size_t high = std::min(end, low + chunk);
+        push([&body, &pending, low, high]()
+        {
+            body(low, high);
+            pending.fetch_sub(1, std::memory_order_release);
+        });
+    }
+
+    // The caller takes the first chunk, then helps with whatever is queued
+    body(begin, std::min(end, begin + chunk));
+    while (pending.load(std::memory_order_acquire) != 0)
+    {
+        if (!runOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+// Work-stealing task scheduler.
+// Every worker owns a deque: it takes its own newest task from the back
+// and, when empty, steals the oldest task from the front of another
+// worker's deque. Threads that wait for a parallelFor run queued tasks
+// themselves, so loops may nest (a task can start its own parallelFor)
+// without tying up workers.
+class ThreadPool
+{
+private:
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues; // One per worker
+    std::vector<std::thread> workers;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queuedCount;
+    std::atomic<size_t> nextQueue; // Round-robin target for tasks from outside the pool
+    bool stopping;
+
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    void push(std::function<void()> task);
+    // Pop from the calling worker's own queue first, then steal
+    bool runOne();
+    void workerLoop(size_t index);
+
+public:
+    // Start threadCount workers; 0 makes every parallelFor run on the caller
+    explicit ThreadPool(size_t threadCount);
+    ~ThreadPool();
+
+    // Process-wide pool sized from the hardware concurrency (callers take part
+    // in their own loops, so it starts one worker fewer than there are cores)
+    static ThreadPool &shared();
+
+    size_t getThreadCount() const;
+
+    // Run body(chunkBegin, chunkEnd) over [begin, end) split into chunks of
+    // at least grain items, and return once every chunk has finished.
+    // Chunks run concurrently and in no particular order.
+    void parallelFor(size_t begin, size_t end, size_t grain,
+                     const std::function<void(size_t, size_t)> &body);
+};
+
+#endif // THREADPOOL_H
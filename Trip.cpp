@@ -2,12 +2,46 @@
 #include "Driver.h"
 #include "Rider.h"
 #include "City.h"
+#include "TripStore.h"
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <cmath>
+#include <chrono>
 
-Trip::Trip(int id, Rider *rider, const std::string &pickup, const std::string &dropoff, int driverId)
-    : id(id), rider(rider), driver(nullptr), driverId(driverId), pickup(pickup), dropoff(dropoff), status(REQUESTED), fare(0.0), city(nullptr) {}
+namespace
+{
+long long nowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+} // namespace
+
+const char *tripStateName(TripState state)
+{
+    switch (state)
+    {
+    case REQUESTED:
+        return "REQUESTED";
+    case ASSIGNED:
+        return "ASSIGNED";
+    case ONGOING:
+        return "ONGOING";
+    case COMPLETED:
+        return "COMPLETED";
+    case CANCELLED:
+        return "CANCELLED";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+Trip::Trip(int id, Rider *rider, int pickup, int dropoff, int driverId)
+    : id(id), rider(rider), driver(nullptr), driverId(driverId), pickup(pickup), dropoff(dropoff), status(REQUESTED), fare(0.0), city(nullptr),
+      requestedAt(nowMs()), finishedAt(0),
+      store(nullptr), prevInState(nullptr), nextInState(nullptr), prevForRider(nullptr), nextForRider(nullptr) {}
 
 int Trip::getId() const
 {
@@ -24,16 +58,28 @@ Driver *Trip::getDriver() const
     return driver;
 }
 
-const std::string &Trip::getPickup() const
+int Trip::getPickup() const
 {
     return pickup;
 }
 
-const std::string &Trip::getDropoff() const
+int Trip::getDropoff() const
 {
     return dropoff;
 }
 
+const std::string &Trip::getPickupName() const
+{
+    static const std::string unknown = "Unknown";
+    return city ? city->getLocationName(pickup) : unknown;
+}
+
+const std::string &Trip::getDropoffName() const
+{
+    static const std::string unknown = "Unknown";
+    return city ? city->getLocationName(dropoff) : unknown;
+}
+
 TripState Trip::getStatus() const
 {
     return status;
@@ -46,31 +92,50 @@ double Trip::getFare() const
 
 std::string Trip::getStateString() const
 {
-    switch (status)
-    {
-    case REQUESTED:
-        return "REQUESTED";
-    case ASSIGNED:
-        return "ASSIGNED";
-    case ONGOING:
-        return "ONGOING";
-    case COMPLETED:
-        return "COMPLETED";
-    case CANCELLED:
-        return "CANCELLED";
-    default:
-        return "UNKNOWN";
-    }
+    return tripStateName(status);
+}
+
+long long Trip::getRequestedAt() const
+{
+    return requestedAt;
+}
+
+long long Trip::getFinishedAt() const
+{
+    return finishedAt;
 }
 
 void Trip::setDriver(Driver *newDriver)
 {
+    Driver *oldDriver = driver;
     driver = newDriver;
+    if (store && oldDriver != newDriver)
+    {
+        store->driverChanged(this, oldDriver);
+    }
 }
 
 void Trip::setStatus(TripState newStatus)
 {
+    TripState oldStatus = status;
     status = newStatus;
+    // Undo can bring a finished trip back to life
+    finishedAt = newStatus == COMPLETED || newStatus == CANCELLED ? nowMs() : 0;
+    if (store && oldStatus != newStatus)
+    {
+        store->statusChanged(this, oldStatus);
+    }
+}
+
+void Trip::restoreTimes(long long requested, long long finished)
+{
+    requestedAt = requested;
+    finishedAt = finished;
+}
+
+void Trip::restoreFare(double savedFare)
+{
+    fare = savedFare;
 }
 
 void Trip::setCity(City *cityRef)
@@ -123,29 +188,33 @@ void Trip::generateReceipt() const
         return;
     }
 
-    std::cout << "\n";
-    std::cout << "╔════════════════════════════════════════╗\n";
-    std::cout << "║       RIDE COMPLETE - RECEIPT          ║\n";
-    std::cout << "╚════════════════════════════════════════╝\n";
-    std::cout << "\n";
-    std::cout << "Passenger:  " << rider->getName() << "\n";
-    std::cout << "Driver:     " << driver->getName() << " (" << driver->getCarModel() << ")\n";
-    std::cout << "Number Plate: " << driver->getNumberPlate() << "\n";
-    std::cout << "\n";
-    std::cout << "Route: " << pickup << " → " << dropoff << "\n";
+    // Built in one piece so receipts printed from several threads neither
+    // interleave nor fight over std::cout's number formatting
+    std::ostringstream receipt;
+    receipt << "\n";
+    receipt << "╔════════════════════════════════════════╗\n";
+    receipt << "║       RIDE COMPLETE - RECEIPT          ║\n";
+    receipt << "╚════════════════════════════════════════╝\n";
+    receipt << "\n";
+    receipt << "Passenger:  " << rider->getName() << "\n";
+    receipt << "Driver:     " << driver->getName() << " (" << driver->getCarModel() << ")\n";
+    receipt << "Number Plate: " << driver->getNumberPlate() << "\n";
+    receipt << "\n";
+    receipt << "Route: " << getPickupName() << " → " << getDropoffName() << "\n";
 
     // Calculate and display distance
     if (city)
     {
         int distance = city->getShortestDistance(pickup, dropoff);
-        std::cout << "Distance: " << distance << " km\n";
+        receipt << "Distance: " << distance << " km\n";
     }
 
-    std::cout << "\n";
-    std::cout << "────────────────────────────────────────\n";
-    std::cout << "TOTAL FARE: PKR " << std::fixed << std::setprecision(2) << fare << "\n";
-    std::cout << "────────────────────────────────────────\n";
-    std::cout << "\n";
-    std::cout << "Thank you for using our ride-sharing service!\n";
-    std::cout << "\n";
+    receipt << "\n";
+    receipt << "────────────────────────────────────────\n";
+    receipt << "TOTAL FARE: PKR " << std::fixed << std::setprecision(2) << fare << "\n";
+    receipt << "────────────────────────────────────────\n";
+    receipt << "\n";
+    receipt << "Thank you for using our ride-sharing service!\n";
+    receipt << "\n";
+    std::cout << receipt.str();
 }
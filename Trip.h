@@ -6,6 +6,7 @@
 class Driver;
 class Rider;
 class City;
+class TripStore;
 
 enum TripState
 {
@@ -16,6 +17,9 @@ enum TripState
     CANCELLED
 };
 
+// Display name of a state ("REQUESTED", ...)
+const char *tripStateName(TripState state);
+
 class Trip
 {
 private:
@@ -23,27 +27,47 @@ private:
     Rider *rider;
     Driver *driver;
     int driverId;
-    std::string pickup;
-    std::string dropoff;
+    int pickup;  // City node ID
+    int dropoff; // City node ID
     TripState status;
     double fare;
     City *city;
+    long long requestedAt; // Milliseconds since the epoch
+    long long finishedAt;  // When it was completed/cancelled, 0 while live
+
+    // Maintained by the owning TripStore, which is told about every status
+    // and driver change
+    friend class TripStore;
+    TripStore *store;
+    Trip *prevInState; // Neighbours in the store's list for this status
+    Trip *nextInState;
+    Trip *prevForRider; // Neighbours among the rider's active trips
+    Trip *nextForRider;
 
 public:
-    Trip(int id, Rider *rider, const std::string &pickup, const std::string &dropoff, int driverId);
+    Trip(int id, Rider *rider, int pickup, int dropoff, int driverId);
 
     int getId() const;
     Rider *getRider() const;
     Driver *getDriver() const;
-    const std::string &getPickup() const;
-    const std::string &getDropoff() const;
+    int getPickup() const;
+    int getDropoff() const;
+    // Location names, resolved through the city for display only
+    const std::string &getPickupName() const;
+    const std::string &getDropoffName() const;
     TripState getStatus() const;
     std::string getStateString() const;
     double getFare() const;
+    long long getRequestedAt() const;
+    long long getFinishedAt() const;
 
     void setDriver(Driver *driver);
     void setStatus(TripState newStatus);
     void setCity(City *cityRef);
+    // Put back timestamps saved elsewhere (log replay)
+    void restoreTimes(long long requested, long long finished);
+    // Put back a fare saved elsewhere (snapshot restore)
+    void restoreFare(double savedFare);
 
     // Fare and receipt methods
     double calculateFare();
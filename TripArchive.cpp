@@ -0,0 +1,338 @@
+#include "TripArchive.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+void putVarint(std::vector<std::uint8_t> &out, long long delta)
+{
+    // Zigzag first, so small negative deltas stay short too
+    std::uint64_t value = ((std::uint64_t)delta << 1) ^ (std::uint64_t)(delta >> 63);
+    while (value >= 0x80)
+    {
+        out.push_back((std::uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((std::uint8_t)value);
+}
+
+// False if the stream ends mid-value or the value runs past 64 bits
+bool getVarint(const std::vector<std::uint8_t> &in, size_t &pos, long long &delta)
+{
+    std::uint64_t value = 0;
+    int shift = 0;
+    while (true)
+    {
+        if (pos >= in.size() || shift > 63)
+        {
+            return false;
+        }
+        std::uint8_t byte = in[pos++];
+        value |= (std::uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+        {
+            break;
+        }
+        shift += 7;
+    }
+    delta = (long long)(value >> 1) ^ -(long long)(value & 1);
+    return true;
+}
+} // namespace
+
+TripArchive::TripArchive() : recordCount(0) {}
+
+long long TripArchive::fieldOf(const TripRecord &record, int column)
+{
+    switch (column)
+    {
+    case TRIP_ID:
+        return record.tripId;
+    case RIDER_ID:
+        return record.riderId;
+    case DRIVER_ID:
+        return record.driverId;
+    case PICKUP:
+        return record.pickup;
+    case DROPOFF:
+        return record.dropoff;
+    case STATE:
+        return record.state;
+    case FARE_CENTS:
+        return std::llround(record.fare * 100.0);
+    case REQUESTED_AT:
+        return record.requestedAt;
+    default:
+        return record.finishedAt;
+    }
+}
+
+void TripArchive::seal(const std::vector<TripRecord> &records, Segment &segment)
+{
+    segment.count = records.size();
+    segment.minTripId = records.front().tripId;
+    segment.maxTripId = records.front().tripId;
+    for (const TripRecord &record : records)
+    {
+        segment.minTripId = std::min(segment.minTripId, record.tripId);
+        segment.maxTripId = std::max(segment.maxTripId, record.tripId);
+    }
+
+    for (int column = 0; column < COLUMN_COUNT; ++column)
+    {
+        std::vector<std::uint8_t> &out = segment.columns[column];
+        long long previous = 0;
+        for (const TripRecord &record : records)
+        {
+            long long value = fieldOf(record, column);
+            putVarint(out, value - previous);
+            previous = value;
+        }
+        out.shrink_to_fit();
+    }
+}
+
+bool TripArchive::decode(const Segment &segment, std::vector<TripRecord> &out)
+{
+    size_t base = out.size();
+    out.resize(base + segment.count);
+    for (int column = 0; column < COLUMN_COUNT; ++column)
+    {
+        const std::vector<std::uint8_t> &in = segment.columns[column];
+        size_t pos = 0;
+        long long value = 0;
+        for (size_t i = 0; i < segment.count; ++i)
+        {
+            long long delta = 0;
+            if (!getVarint(in, pos, delta))
+            {
+                out.resize(base);
+                return false;
+            }
+            value += delta;
+            TripRecord &record = out[base + i];
+            switch (column)
+            {
+            case TRIP_ID:
+                record.tripId = (int)value;
+                break;
+            case RIDER_ID:
+                record.riderId = (int)value;
+                break;
+            case DRIVER_ID:
+                record.driverId = (int)value;
+                break;
+            case PICKUP:
+                record.pickup = (int)value;
+                break;
+            case DROPOFF:
+                record.dropoff = (int)value;
+                break;
+            case STATE:
+                record.state = (TripState)value;
+                break;
+            case FARE_CENTS:
+                record.fare = value / 100.0;
+                break;
+            case REQUESTED_AT:
+                record.requestedAt = value;
+                break;
+            default:
+                record.finishedAt = value;
+                break;
+            }
+        }
+        if (pos != in.size())
+        {
+            out.resize(base);
+            return false;
+        }
+    }
+    return true;
+}
+
+void TripArchive::append(const TripRecord &record)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    appendLocked(record);
+}
+
+void TripArchive::appendLocked(const TripRecord &record)
+{
+    open.push_back(record);
+    countLocked(record);
+
+    if (open.size() >= SEGMENT_SIZE)
+    {
+        std::shared_ptr<Segment> segment(new Segment());
+        seal(open, *segment);
+        segments.push_back(segment);
+        open.clear();
+    }
+}
+
+void TripArchive::countLocked(const TripRecord &record)
+{
+    ++recordCount;
+    if (record.driverId >= 0)
+    {
+        if ((size_t)record.driverId >= driverStats.size())
+        {
+            DriverTripStats empty = {0, 0, 0.0};
+            driverStats.resize(record.driverId + 1, empty);
+        }
+        DriverTripStats &stats = driverStats[record.driverId];
+        if (record.state == COMPLETED)
+        {
+            ++stats.completed;
+            stats.earnings += record.fare;
+        }
+        else
+        {
+            ++stats.cancelled;
+        }
+    }
+}
+
+size_t TripArchive::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return recordCount;
+}
+
+bool TripArchive::find(int tripId, TripRecord &record) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const TripRecord &candidate : open)
+    {
+        if (candidate.tripId == tripId)
+        {
+            record = candidate;
+            return true;
+        }
+    }
+
+    std::vector<TripRecord> decoded;
+    for (const std::shared_ptr<const Segment> &segment : segments)
+    {
+        if (tripId < segment->minTripId || tripId > segment->maxTripId)
+        {
+            continue;
+        }
+        decoded.clear();
+        decode(*segment, decoded);
+        for (const TripRecord &candidate : decoded)
+        {
+            if (candidate.tripId == tripId)
+            {
+                record = candidate;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::vector<TripRecord> TripArchive::getRecords() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<TripRecord> result;
+    result.reserve(recordCount);
+    for (const std::shared_ptr<const Segment> &segment : segments)
+    {
+        decode(*segment, result);
+    }
+    result.insert(result.end(), open.begin(), open.end());
+    return result;
+}
+
+std::vector<TripRecord> TripArchive::getDriverHistory(int driverId) const
+{
+    std::vector<TripRecord> all = getRecords();
+    std::vector<TripRecord> result;
+    for (const TripRecord &record : all)
+    {
+        if (record.driverId == driverId)
+        {
+            result.push_back(record);
+        }
+    }
+    return result;
+}
+
+DriverTripStats TripArchive::getDriverStats(int driverId) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (driverId < 0 || (size_t)driverId >= driverStats.size())
+    {
+        DriverTripStats empty = {0, 0, 0.0};
+        return empty;
+    }
+    return driverStats[driverId];
+}
+
+void TripArchive::getContents(std::vector<std::shared_ptr<const Segment>> &sealed,
+                              std::vector<TripRecord> &unsealed) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    sealed = segments;
+    unsealed = open;
+}
+
+bool TripArchive::restore(const std::vector<std::shared_ptr<const Segment>> &sealed,
+                          const std::vector<TripRecord> &unsealed)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (recordCount != 0)
+    {
+        return false;
+    }
+
+    // Decoded once to check the segments and total them per driver; the
+    // segments themselves are kept as they are
+    std::vector<TripRecord> decoded;
+    bool valid = true;
+    for (size_t i = 0; i < sealed.size() && valid; ++i)
+    {
+        const Segment *segment = sealed[i].get();
+        decoded.clear();
+        valid = segment && segment->count > 0 && segment->count <= SEGMENT_SIZE && decode(*segment, decoded);
+        for (size_t r = 0; r < decoded.size() && valid; ++r)
+        {
+            const TripRecord &record = decoded[r];
+            valid = record.tripId >= segment->minTripId && record.tripId <= segment->maxTripId &&
+                    (record.state == COMPLETED || record.state == CANCELLED);
+            countLocked(record);
+        }
+    }
+    if (!valid)
+    {
+        driverStats.clear();
+        recordCount = 0;
+        return false;
+    }
+    segments = sealed;
+
+    for (const TripRecord &record : unsealed)
+    {
+        appendLocked(record);
+    }
+    return true;
+}
+
+size_t TripArchive::getMemoryUsage() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t bytes = open.capacity() * sizeof(TripRecord) + driverStats.capacity() * sizeof(DriverTripStats) +
+                   segments.capacity() * sizeof(std::shared_ptr<const Segment>);
+    // Each segment is a separate allocation behind its pointer
+    for (const std::shared_ptr<const Segment> &segment : segments)
+    {
+        bytes += sizeof(Segment);
+        for (int column = 0; column < COLUMN_COUNT; ++column)
+        {
+            bytes += segment->columns[column].capacity();
+        }
+    }
+    return bytes;
+}
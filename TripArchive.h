@@ -0,0 +1,109 @@
+#ifndef TRIPARCHIVE_H
+#define TRIPARCHIVE_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <memory>
+#include "Trip.h"
+
+// A finished trip as kept in the archive
+struct TripRecord
+{
+    int tripId;
+    int riderId;
+    int driverId; // -1 if no driver was ever assigned
+    int pickup;   // City node IDs
+    int dropoff;
+    TripState state; // COMPLETED or CANCELLED
+    double fare;
+    long long requestedAt; // Milliseconds since the epoch
+    long long finishedAt;
+};
+
+// Per-driver totals over archived trips
+struct DriverTripStats
+{
+    size_t completed;
+    size_t cancelled;
+    double earnings; // Fares of completed trips
+};
+
+// Cold storage for finished trips.
+// Records collect in an open segment and are sealed SEGMENT_SIZE at a time
+// into column-oriented byte streams: each column stores the delta from the
+// previous row, zigzag and varint encoded, so sequential IDs, nearby nodes
+// and close timestamps take one or two bytes instead of four or eight.
+// Per-driver totals are kept on append, so stats never decode anything.
+// All members lock internally.
+class TripArchive
+{
+public:
+    static const size_t SEGMENT_SIZE = 1024;
+
+    enum Column
+    {
+        TRIP_ID,
+        RIDER_ID,
+        DRIVER_ID,
+        PICKUP,
+        DROPOFF,
+        STATE,
+        FARE_CENTS,
+        REQUESTED_AT,
+        FINISHED_AT,
+        COLUMN_COUNT
+    };
+
+    // A sealed block of records, one encoded byte stream per column; never
+    // changed once sealed, so copies of the archive can share it
+    struct Segment
+    {
+        size_t count;
+        int minTripId; // Lets lookups skip segments
+        int maxTripId;
+        std::vector<std::uint8_t> columns[COLUMN_COUNT];
+    };
+
+private:
+    mutable std::mutex mutex;
+    std::vector<std::shared_ptr<const Segment>> segments;
+    std::vector<TripRecord> open; // Not yet sealed
+    std::vector<DriverTripStats> driverStats;
+    size_t recordCount;
+
+    static long long fieldOf(const TripRecord &record, int column);
+    static void seal(const std::vector<TripRecord> &records, Segment &segment);
+    // False if a column is malformed (only possible for segments read from disk)
+    static bool decode(const Segment &segment, std::vector<TripRecord> &out);
+    // Callers hold the mutex
+    void appendLocked(const TripRecord &record);
+    // Record and per-driver totals only
+    void countLocked(const TripRecord &record);
+
+public:
+    TripArchive();
+
+    void append(const TripRecord &record);
+
+    size_t size() const;
+    // Look up one archived trip; false if it is not here
+    bool find(int tripId, TripRecord &record) const;
+    // Every archived trip in the order it was archived
+    std::vector<TripRecord> getRecords() const;
+    std::vector<TripRecord> getDriverHistory(int driverId) const;
+    DriverTripStats getDriverStats(int driverId) const;
+
+    // The sealed segments as they are (shared, not copied or decoded) and
+    // the records not sealed yet; enough to rebuild the archive elsewhere
+    void getContents(std::vector<std::shared_ptr<const Segment>> &sealed, std::vector<TripRecord> &unsealed) const;
+    // Rebuild an empty archive from getContents() output, e.g. read back
+    // from a snapshot; false (leaving it empty) if a segment is malformed
+    bool restore(const std::vector<std::shared_ptr<const Segment>> &sealed, const std::vector<TripRecord> &unsealed);
+
+    // Bytes held by sealed segments and the open segment
+    size_t getMemoryUsage() const;
+};
+
+#endif // TRIPARCHIVE_H
@@ -0,0 +1,300 @@
+#include "TripStore.h"
+#include "Driver.h"
+#include "Rider.h"
+#include <algorithm>
+
+namespace
+{
+bool byId(const Trip *a, const Trip *b)
+{
+    return a->getId() < b->getId();
+}
+} // namespace
+
+TripStore::TripStore() : nextId(0)
+{
+    for (int i = 0; i < STATE_COUNT; ++i)
+    {
+        stateHead[i] = nullptr;
+        stateCount[i] = 0;
+    }
+}
+
+bool TripStore::isActive(TripState state)
+{
+    return state == REQUESTED || state == ASSIGNED || state == ONGOING;
+}
+
+void TripStore::linkState(Trip *trip)
+{
+    int state = trip->status;
+    trip->prevInState = nullptr;
+    trip->nextInState = stateHead[state];
+    if (stateHead[state])
+    {
+        stateHead[state]->prevInState = trip;
+    }
+    stateHead[state] = trip;
+    ++stateCount[state];
+}
+
+void TripStore::unlinkState(Trip *trip, TripState state)
+{
+    if (trip->prevInState)
+    {
+        trip->prevInState->nextInState = trip->nextInState;
+    }
+    else
+    {
+        stateHead[state] = trip->nextInState;
+    }
+    if (trip->nextInState)
+    {
+        trip->nextInState->prevInState = trip->prevInState;
+    }
+    trip->prevInState = nullptr;
+    trip->nextInState = nullptr;
+    --stateCount[state];
+}
+
+void TripStore::linkOwners(Trip *trip)
+{
+    size_t rider = (size_t)trip->rider->getId();
+    if (rider >= riderHead.size())
+    {
+        riderHead.resize(rider + 1, nullptr);
+    }
+    trip->prevForRider = nullptr;
+    trip->nextForRider = riderHead[rider];
+    if (riderHead[rider])
+    {
+        riderHead[rider]->prevForRider = trip;
+    }
+    riderHead[rider] = trip;
+
+    setDriverEntry(trip->driver, trip);
+}
+
+void TripStore::unlinkOwners(Trip *trip)
+{
+    if (trip->prevForRider)
+    {
+        trip->prevForRider->nextForRider = trip->nextForRider;
+    }
+    else
+    {
+        riderHead[trip->rider->getId()] = trip->nextForRider;
+    }
+    if (trip->nextForRider)
+    {
+        trip->nextForRider->prevForRider = trip->prevForRider;
+    }
+    trip->prevForRider = nullptr;
+    trip->nextForRider = nullptr;
+
+    clearDriverEntry(trip->driver, trip);
+}
+
+void TripStore::setDriverEntry(const Driver *driver, Trip *trip)
+{
+    if (!driver)
+    {
+        return;
+    }
+    size_t id = (size_t)driver->getId();
+    if (id >= driverActive.size())
+    {
+        driverActive.resize(id + 1, nullptr);
+    }
+    driverActive[id] = trip;
+}
+
+void TripStore::clearDriverEntry(const Driver *driver, const Trip *trip)
+{
+    // Only if it still points here; an undo may have handed the driver on
+    if (driver && (size_t)driver->getId() < driverActive.size() && driverActive[driver->getId()] == trip)
+    {
+        driverActive[driver->getId()] = nullptr;
+    }
+}
+
+void TripStore::statusChanged(Trip *trip, TripState oldStatus)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    bool wasActive = isActive(oldStatus);
+    bool nowActive = isActive(trip->status);
+
+    unlinkState(trip, oldStatus);
+    linkState(trip);
+
+    if (wasActive && !nowActive)
+    {
+        unlinkOwners(trip);
+    }
+    else if (!wasActive && nowActive)
+    {
+        linkOwners(trip);
+    }
+}
+
+void TripStore::driverChanged(Trip *trip, Driver *oldDriver)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (isActive(trip->status))
+    {
+        clearDriverEntry(oldDriver, trip);
+        setDriverEntry(trip->driver, trip);
+    }
+}
+
+Trip *TripStore::create(Rider *rider, int pickup, int dropoff)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Trip *trip = pool.create(nextId++, rider, pickup, dropoff, -1);
+    trip->store = this;
+    trips[trip->id] = trip;
+    linkState(trip);
+    linkOwners(trip);
+    return trip;
+}
+
+bool TripStore::remove(Trip *trip)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!trip || isActive(trip->status))
+        {
+            return false;
+        }
+        std::unordered_map<int, Trip *>::iterator found = trips.find(trip->id);
+        if (found == trips.end() || found->second != trip)
+        {
+            return false;
+        }
+        unlinkState(trip, trip->status);
+        trips.erase(found);
+    }
+    pool.destroy(trip);
+    return true;
+}
+
+Trip *TripStore::recreate(int id, Rider *rider, int pickup, int dropoff)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id < 0 || trips.count(id) != 0)
+    {
+        return nullptr;
+    }
+    Trip *trip = pool.create(id, rider, pickup, dropoff, -1);
+    trip->store = this;
+    trips[id] = trip;
+    nextId = std::max(nextId, id + 1);
+    linkState(trip);
+    linkOwners(trip);
+    return trip;
+}
+
+void TripStore::skipIds(int nextTripId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    nextId = std::max(nextId, nextTripId);
+}
+
+Trip *TripStore::get(int id) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unordered_map<int, Trip *>::const_iterator found = trips.find(id);
+    return found != trips.end() ? found->second : nullptr;
+}
+
+std::vector<Trip *> TripStore::getAll() const
+{
+    std::vector<Trip *> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.reserve(trips.size());
+        for (std::unordered_map<int, Trip *>::const_iterator it = trips.begin(); it != trips.end(); ++it)
+        {
+            result.push_back(it->second);
+        }
+    }
+    std::sort(result.begin(), result.end(), byId);
+    return result;
+}
+
+size_t TripStore::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return trips.size();
+}
+
+size_t TripStore::getCreatedCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return (size_t)nextId;
+}
+
+std::vector<Trip *> TripStore::getInState(TripState state) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Trip *> result;
+    if (state < 0 || state >= STATE_COUNT)
+    {
+        return result;
+    }
+    result.reserve(stateCount[state]);
+    for (Trip *trip = stateHead[state]; trip; trip = trip->nextInState)
+    {
+        result.push_back(trip);
+    }
+    return result;
+}
+
+size_t TripStore::getCountInState(TripState state) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return state >= 0 && state < STATE_COUNT ? stateCount[state] : 0;
+}
+
+std::vector<Trip *> TripStore::getActive() const
+{
+    std::vector<Trip *> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        result.reserve(stateCount[REQUESTED] + stateCount[ASSIGNED] + stateCount[ONGOING]);
+        for (int state = 0; state < ACTIVE_STATES; ++state)
+        {
+            for (Trip *trip = stateHead[state]; trip; trip = trip->nextInState)
+            {
+                result.push_back(trip);
+            }
+        }
+    }
+    std::sort(result.begin(), result.end(), byId);
+    return result;
+}
+
+Trip *TripStore::getActiveTripForRider(const Rider *rider) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!rider || (size_t)rider->getId() >= riderHead.size())
+    {
+        return nullptr;
+    }
+    return riderHead[rider->getId()];
+}
+
+Trip *TripStore::getActiveTripForDriver(const Driver *driver) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!driver || (size_t)driver->getId() >= driverActive.size())
+    {
+        return nullptr;
+    }
+    return driverActive[driver->getId()];
+}
+
+PoolStats TripStore::getMemoryStats() const
+{
+    return pool.getStats();
+}
@@ -0,0 +1,94 @@
+#ifndef TRIPSTORE_H
+#define TRIPSTORE_H
+
+#include <vector>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include "Trip.h"
+#include "ObjectPool.h"
+
+// Owns every resident trip and indexes them.
+// Each trip sits on an intrusive list for its status, and each rider and
+// driver maps to their active trips; Trip::setStatus and Trip::setDriver keep
+// all of it current. Live-trip queries therefore cost O(active trips) or
+// O(1), however much history has built up. Finished trips stay resident
+// until they are moved to a TripArchive and removed.
+// All members lock internally.
+class TripStore
+{
+private:
+    static const int ACTIVE_STATES = 3; // REQUESTED, ASSIGNED, ONGOING
+    static const int STATE_COUNT = 5;
+
+    mutable std::mutex mutex;
+    ObjectPool<Trip> pool;
+    // Resident trips by ID; removed ones leave no trace, so the table
+    // tracks what is resident rather than every ID ever issued
+    std::unordered_map<int, Trip *> trips;
+    int nextId;
+
+    Trip *stateHead[STATE_COUNT];
+    size_t stateCount[STATE_COUNT];
+    std::vector<Trip *> riderHead;    // Rider ID -> newest active trip
+    std::vector<Trip *> driverActive; // Driver ID -> active trip
+
+    TripStore(const TripStore &);
+    TripStore &operator=(const TripStore &);
+
+    static bool isActive(TripState state);
+
+    // Callers hold the mutex
+    void linkState(Trip *trip);
+    void unlinkState(Trip *trip, TripState state);
+    // Rider list and driver entry, kept for active trips only
+    void linkOwners(Trip *trip);
+    void unlinkOwners(Trip *trip);
+    void setDriverEntry(const Driver *driver, Trip *trip);
+    void clearDriverEntry(const Driver *driver, const Trip *trip);
+
+    // Called by Trip
+    friend class Trip;
+    void statusChanged(Trip *trip, TripState oldStatus);
+    void driverChanged(Trip *trip, Driver *oldDriver);
+
+public:
+    TripStore();
+
+    // New REQUESTED trip with the next trip ID
+    Trip *create(Rider *rider, int pickup, int dropoff);
+    // New REQUESTED trip with a given ID, for rebuilding saved state; IDs may
+    // arrive out of order. nullptr if the ID is taken.
+    Trip *recreate(int id, Rider *rider, int pickup, int dropoff);
+
+    // Destroy a COMPLETED or CANCELLED trip; false (and nothing happens) for
+    // a live one. Pointers to it dangle afterwards.
+    bool remove(Trip *trip);
+
+    // Treat every ID below nextTripId as issued (restoring archived history)
+    void skipIds(int nextTripId);
+
+    // Trip by ID, nullptr if unknown or removed
+    Trip *get(int id) const;
+    // Every resident trip, in ID order
+    std::vector<Trip *> getAll() const;
+    // Resident trips
+    size_t size() const;
+    // Trips ever created, removed ones included
+    size_t getCreatedCount() const;
+
+    // Resident trips currently in a state, newest change first
+    std::vector<Trip *> getInState(TripState state) const;
+    size_t getCountInState(TripState state) const;
+    // Every REQUESTED, ASSIGNED or ONGOING trip, in ID order
+    std::vector<Trip *> getActive() const;
+
+    // The rider's newest active trip, nullptr if none
+    Trip *getActiveTripForRider(const Rider *rider) const;
+    // The trip the driver is serving, nullptr if none
+    Trip *getActiveTripForDriver(const Driver *driver) const;
+
+    PoolStats getMemoryStats() const;
+};
+
+#endif // TRIPSTORE_H
@@ -114,7 +114,8 @@ void bookRide()
     std::cin.ignore();
 
     std::string pickupLocation = g_system->getLocationById(pickupCityId, pickupLocId);
-    if (pickupLocation.empty())
+    int pickupNode = g_system->getLocationNodeById(pickupCityId, pickupLocId);
+    if (pickupNode == -1)
     {
         std::cout << "[ERROR] Invalid location selection.\n";
         return;
@@ -143,13 +144,14 @@ void bookRide()
     std::cin.ignore();
 
     std::string dropoffLocation = g_system->getLocationById(dropoffCityId, dropoffLocId);
-    if (dropoffLocation.empty())
+    int dropoffNode = g_system->getLocationNodeById(dropoffCityId, dropoffLocId);
+    if (dropoffNode == -1)
     {
         std::cout << "[ERROR] Invalid location selection.\n";
         return;
     }
 
-    if (pickupLocation == dropoffLocation)
+    if (pickupNode == dropoffNode)
     {
         std::cout << "[ERROR] Pickup and dropoff must be different!\n";
         return;
@@ -157,21 +159,21 @@ void bookRide()
 
     // Step 5: Show available drivers and select one
     std::cout << "\nSTEP 5: Select Driver\n";
-    g_system->displayAvailableDriversWithETA(pickupLocation);
+    g_system->displayAvailableDriversWithETA(pickupNode);
 
     int driverChoice;
     std::cout << "Enter Driver Number (1-10): ";
     std::cin >> driverChoice;
     std::cin.ignore();
 
-    const std::vector<Driver *> &allDrivers = g_system->getAllDrivers();
-    if (driverChoice < 1 || driverChoice > (int)allDrivers.size())
+    const DriverStore &drivers = g_system->getDriverStore();
+    if (driverChoice < 1 || driverChoice > (int)drivers.size())
     {
         std::cout << "[ERROR] Invalid driver selection.\n";
         return;
     }
 
-    Driver *selectedDriver = allDrivers[driverChoice - 1];
+    Driver *selectedDriver = drivers.get(driverChoice - 1);
     if (!selectedDriver || !selectedDriver->getIsAvailable())
     {
         std::cout << "[ERROR] Invalid driver selection or driver not available.\n";
@@ -189,13 +191,19 @@ void bookRide()
         return;
     }
 
-    Rider *rider = g_system->addRider(riderName, pickupLocation);
-    Trip *trip = g_system->requestTrip(rider, pickupLocation, dropoffLocation, selectedDriver);
+    // Node IDs, not names: a name like "Saddar" exists in more than one city
+    Rider *rider = g_system->addRider(riderName, pickupNode);
+    Trip *trip = g_system->requestTrip(rider, pickupNode, dropoffNode, selectedDriver);
 
     if (!trip)
     {
         std::cout << "[ERROR] Failed to create trip.\n";
     }
+    else if (trip->getDriver() != selectedDriver)
+    {
+        // Someone else booked them first; the request waits for the next free driver
+        std::cout << "[INFO] Trip #" << trip->getId() << " is waiting for the next free driver.\n";
+    }
     else
     {
         // Calculate and display estimated fare
@@ -221,36 +229,13 @@ void viewTripStatus()
     if (!g_system)
         return;
 
-    const std::vector<Trip *> &trips = g_system->getAllTrips();
-
-    if (trips.empty())
+    if (g_system->getTripCount() == 0)
     {
         std::cout << "\n[INFO] No trips available.\n";
         return;
     }
 
-    std::cout << "\n=============== TRIP STATUS ===============\n";
-    std::cout << "ID | Rider        | From    | To      | Driver | Status\n";
-    std::cout << "---+--------------+---------+---------+--------+----------\n";
-
-    for (const Trip *trip : trips)
-    {
-        const char *driverName = "None";
-        if (trip->getDriver())
-        {
-            driverName = trip->getDriver()->getName().c_str();
-        }
-
-        printf("%2d | %-12s | %-7s | %-7s | %-6s | %s\n",
-               trip->getId(),
-               trip->getRider()->getName().c_str(),
-               trip->getPickup().c_str(),
-               trip->getDropoff().c_str(),
-               driverName,
-               trip->getStateString().c_str());
-    }
-
-    std::cout << "==========================================\n";
+    g_system->displayTripHistory();
 
     // Option to complete a trip
     std::cout << "\nDo you want to complete a trip? (Y/N): ";
@@ -265,13 +250,11 @@ void viewTripStatus()
         std::cin >> tripId;
         std::cin.ignore();
 
-        for (Trip *trip : trips)
+        Trip *trip = g_system->getTripById(tripId);
+        if (trip && trip->getStatus() != COMPLETED && trip->getStatus() != CANCELLED)
         {
-            if (trip->getId() == tripId && trip->getStatus() != COMPLETED && trip->getStatus() != CANCELLED)
-            {
-                g_system->completeTrip(trip);
-                return;
-            }
+            g_system->completeTrip(trip);
+            return;
         }
         std::cout << "[ERROR] Invalid trip ID or trip already completed/cancelled.\n";
     }
@@ -283,29 +266,24 @@ void cancelTrip()
     if (!g_system)
         return;
 
-    const std::vector<Trip *> &trips = g_system->getAllTrips();
-
-    if (trips.empty())
+    if (g_system->getTripCount() == 0)
     {
         std::cout << "\n[ERROR] No trips available to cancel.\n";
         return;
     }
 
     std::cout << "\n===== ACTIVE TRIPS =====\n";
-    int activeCount = 0;
-    for (const Trip *trip : trips)
+    std::vector<Trip *> active = g_system->getActiveTrips();
+    for (size_t i = 0; i < active.size(); ++i)
     {
-        if (trip->getStatus() != CANCELLED && trip->getStatus() != COMPLETED)
-        {
-            printf(" %d. Trip #%d: %s (%s)\n",
-                   ++activeCount,
-                   trip->getId(),
-                   trip->getRider()->getName().c_str(),
-                   trip->getStateString().c_str());
-        }
+        printf(" %d. Trip #%d: %s (%s)\n",
+               (int)(i + 1),
+               active[i]->getId(),
+               active[i]->getRider()->getName().c_str(),
+               active[i]->getStateString().c_str());
     }
 
-    if (activeCount == 0)
+    if (active.empty())
     {
         std::cout << "[INFO] No active trips to cancel.\n";
         return;
@@ -317,18 +295,10 @@ void cancelTrip()
     std::cin >> tripChoice;
     std::cin.ignore();
 
-    activeCount = 0;
-    for (Trip *trip : trips)
+    if (tripChoice >= 1 && tripChoice <= (int)active.size())
     {
-        if (trip->getStatus() != CANCELLED && trip->getStatus() != COMPLETED)
-        {
-            activeCount++;
-            if (activeCount == tripChoice)
-            {
-                g_system->cancelTrip(trip);
-                return;
-            }
-        }
+        g_system->cancelTrip(active[tripChoice - 1]);
+        return;
     }
 
     std::cout << "[ERROR] Invalid trip selection.\n";
@@ -353,9 +323,20 @@ int main()
     RideShareSystem rideSystem;
     g_system = &rideSystem;
 
-    // Initialize Pakistani cities and fleet
-    rideSystem.setupPakistaniCities();
-    setupFleet(rideSystem);
+    // Start from the last snapshot if there is one, otherwise set up
+    // the Pakistani cities and fleet from scratch
+    rideSystem.enableSnapshots("rideshare.snapshot", 200);
+    if (!rideSystem.loadSnapshot())
+    {
+        rideSystem.setupPakistaniCities();
+        setupFleet(rideSystem);
+    }
+
+    // Bring back trips logged since then and log every change from here on
+    if (!rideSystem.openEventLog("rideshare_events.log"))
+    {
+        std::cout << "[ERROR] Event log unavailable; changes will not survive a restart.\n";
+    }
 
     // Clear screen and display professional header
     clearScreen();
@@ -364,6 +345,11 @@ int main()
     int choice = 0;
     while (true)
     {
+        // No trip pointers are held between menu actions, so finished trips
+        // can be moved to the archive here
+        rideSystem.archiveFinishedTrips();
+        rideSystem.pollSnapshot();
+
         displayMainMenu();
         std::cin >> choice;
         std::cin.ignore();
@@ -390,8 +376,8 @@ int main()
             std::cout << "\n =============================================\n";
             std::cout << "   Thank you for using SNAPPY RIDES!          \n";
             std::cout << " =============================================\n";
-            std::cout << "       Total Trips: " << rideSystem.getAllTrips().size() << "\n";
-            std::cout << "       Total Drivers: " << rideSystem.getAllDrivers().size() << "\n";
+            std::cout << "       Total Trips: " << rideSystem.getTripCount() << "\n";
+            std::cout << "       Total Drivers: " << rideSystem.getDriverStore().size() << "\n";
             std::cout << " =============================================\n\n";
             return 0;
 
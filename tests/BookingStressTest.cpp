@@ -0,0 +1,199 @@
+// Many threads book, complete, cancel and undo trips against a fleet much
+// smaller than the demand. Between rounds, every live trip is checked: no
+// driver may hold two of them, and nobody holding one may be available.
+
+#include "RideShareSystem.h"
+#include "Driver.h"
+#include "Rider.h"
+#include "Trip.h"
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const int THREADS = 8;
+const int ROUNDS = 20;
+const int OPS_PER_ROUND = 300;
+const char *LOCATIONS[] = {"A", "B", "C", "D", "E", "F"};
+const int LOCATION_COUNT = 6;
+
+void runWorker(RideShareSystem &system, Rider *rider, std::vector<Trip *> &trips, std::mt19937 &random,
+               const std::atomic<bool> &start)
+{
+    // Start together, or the first threads finish before the last begin
+    while (!start)
+    {
+        std::this_thread::yield();
+    }
+    for (int op = 0; op < OPS_PER_ROUND; ++op)
+    {
+        int roll = (int)(random() % 100);
+        // Finishing the newest trips keeps undo entries that hand a driver
+        // back near the top of the stack, racing other threads' bookings
+        Trip *recent = trips.empty() ? nullptr : trips[trips.size() - 1 - random() % std::min<size_t>(2, trips.size())];
+        if (roll < 35 || !recent)
+        {
+            int pickup = (int)(random() % LOCATION_COUNT);
+            int dropoff = (int)(random() % LOCATION_COUNT);
+            Trip *trip = system.requestTrip(rider, LOCATIONS[pickup], LOCATIONS[dropoff]);
+            if (trip)
+            {
+                trips.push_back(trip);
+            }
+        }
+        else if (roll < 55)
+        {
+            // Trips that already finished, or have no driver yet, are refused by the system
+            system.completeTrip(recent);
+        }
+        else if (roll < 75)
+        {
+            // Any of them, so requests left waiting don't pile up
+            system.cancelTrip(trips[random() % trips.size()]);
+        }
+        else
+        {
+            system.undoLastAction();
+        }
+    }
+}
+
+// Number of violations found among the live trips
+int checkDrivers(RideShareSystem &system, const std::string &when)
+{
+    int violations = 0;
+    std::map<const Driver *, int> liveTrips;
+    for (Trip *trip : system.getActiveTrips())
+    {
+        if (trip->getStatus() != ASSIGNED && trip->getStatus() != ONGOING)
+        {
+            continue;
+        }
+        Driver *driver = trip->getDriver();
+        if (!driver)
+        {
+            std::clog << when << ": Trip #" << trip->getId() << " is live without a driver\n";
+            ++violations;
+            continue;
+        }
+        if (++liveTrips[driver] == 2)
+        {
+            std::clog << when << ": driver " << driver->getId() << " holds two live trips\n";
+            ++violations;
+        }
+        if (driver->getIsAvailable())
+        {
+            std::clog << when << ": driver " << driver->getId() << " is on Trip #"
+                      << trip->getId() << " but marked available\n";
+            ++violations;
+        }
+    }
+    return violations;
+}
+
+void buildCity(RideShareSystem &system)
+{
+    for (int i = 0; i < LOCATION_COUNT; ++i)
+    {
+        system.addLocation(LOCATIONS[i], 1 + i / 3);
+    }
+    for (int i = 0; i + 1 < LOCATION_COUNT; ++i)
+    {
+        system.addRoad(LOCATIONS[i], LOCATIONS[i + 1], 4 + i);
+    }
+}
+
+// The interleaving the stress rounds hunt for, played out in order: a
+// cancelled trip's driver is given to a request made before the
+// cancellation, then the cancellation is undone
+int checkHandBackAfterRebooking()
+{
+    RideShareSystem system;
+    buildCity(system);
+    system.addDriver("Driver 1", "A", 1);
+    Rider *rider = system.addRider("Rider", "A");
+
+    Trip *first = system.requestTrip(rider, "A", "B");
+    system.enableBatchDispatch(60000);
+    Trip *second = system.requestTrip(rider, "C", "D"); // Waits in the batch
+    system.cancelTrip(first);
+    system.flushDispatchBatch(); // Takes the driver the cancellation freed
+    bool undone = system.undoLastAction();
+
+    int violations = checkDrivers(system, "Hand-back scenario");
+    if (undone || second->getStatus() != ASSIGNED || first->getStatus() != CANCELLED)
+    {
+        std::clog << "Undoing the cancellation should fail while the driver is on Trip #" << second->getId() << "\n";
+        ++violations;
+    }
+    return violations;
+}
+} // namespace
+
+int main()
+{
+    // The system reports every booking and refusal; keep the output to the
+    // verdict (violations go to std::clog)
+    std::streambuf *out = std::cout.rdbuf(nullptr);
+    std::streambuf *err = std::cerr.rdbuf(nullptr);
+
+    int violations = checkHandBackAfterRebooking();
+
+    RideShareSystem system;
+    buildCity(system);
+    // Far fewer drivers than threads, so every booking competes
+    system.addDriver("Driver 1", "A", 1);
+    system.addDriver("Driver 2", "C", 1);
+    system.addDriver("Driver 3", "F", 2);
+
+    std::vector<Rider *> riders;
+    std::vector<std::vector<Trip *>> trips(THREADS);
+    std::vector<std::mt19937> randoms;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        riders.push_back(system.addRider("Rider", LOCATIONS[t % LOCATION_COUNT]));
+        randoms.push_back(std::mt19937(1000 + t));
+    }
+
+    for (int round = 0; round < ROUNDS && violations == 0; ++round)
+    {
+        // Odd rounds batch requests: batch assignment records no undo entry,
+        // so an undo can hand back a driver a batch just gave someone else
+        if (round % 2 == 1)
+        {
+            system.enableBatchDispatch(1);
+        }
+        std::atomic<bool> start(false);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < THREADS; ++t)
+        {
+            workers.push_back(std::thread(runWorker, std::ref(system), riders[t], std::ref(trips[t]), std::ref(randoms[t]),
+                                          std::cref(start)));
+        }
+        start = true;
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+        system.disableBatchDispatch();
+
+        violations += checkDrivers(system, "Round " + std::to_string(round));
+    }
+
+    std::cout.rdbuf(out);
+    std::cerr.rdbuf(err);
+    if (violations > 0)
+    {
+        std::cout << "[ERROR] " << violations << " double bookings or stale drivers found\n";
+        return 1;
+    }
+    std::cout << "[OK] " << system.getTripCount() << " trips booked by " << THREADS
+              << " threads; no driver held two live trips\n";
+    return 0;
+}
@@ -0,0 +1,186 @@
+// Many threads book, complete, cancel and undo trips with the event log on,
+// then a second system replays the log. Trips, drivers and the undo stack
+// (checked by undoing everything on both sides) must come back as they were.
+
+#include "RideShareSystem.h"
+#include "Driver.h"
+#include "Rider.h"
+#include "Trip.h"
+#include <iostream>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const int THREADS = 8;
+const int OPS = 400;
+const int UNDO_STEPS = 300;
+const char *LOCATIONS[] = {"A", "B", "C", "D", "E", "F"};
+const int LOCATION_COUNT = 6;
+const char *LOG_PATH = "EventLogReplayTest.log";
+const char *COPY_PATH = "EventLogReplayTest.copy.log";
+const char *FIRST_SEGMENT = ".000001"; // Nothing here rolls the log
+
+void buildCity(RideShareSystem &system)
+{
+    for (int i = 0; i < LOCATION_COUNT; ++i)
+    {
+        system.addLocation(LOCATIONS[i], 1 + i / 3);
+    }
+    for (int i = 0; i + 1 < LOCATION_COUNT; ++i)
+    {
+        system.addRoad(LOCATIONS[i], LOCATIONS[i + 1], 4 + i);
+    }
+    system.addDriver("Driver 1", "A", 1);
+    system.addDriver("Driver 2", "C", 1);
+    system.addDriver("Driver 3", "F", 2);
+}
+
+void removeLog(const std::string &path)
+{
+    std::remove((path + FIRST_SEGMENT).c_str());
+}
+
+void runWorker(RideShareSystem &system, Rider *rider, std::mt19937 &random, const std::atomic<bool> &start)
+{
+    while (!start)
+    {
+        std::this_thread::yield();
+    }
+    std::vector<Trip *> trips;
+    for (int op = 0; op < OPS; ++op)
+    {
+        int roll = (int)(random() % 100);
+        if (roll < 40 || trips.empty())
+        {
+            Trip *trip = system.requestTrip(rider, LOCATIONS[random() % LOCATION_COUNT],
+                                            LOCATIONS[random() % LOCATION_COUNT]);
+            if (trip)
+            {
+                trips.push_back(trip);
+            }
+        }
+        else if (roll < 60)
+        {
+            system.completeTrip(trips.back());
+        }
+        else if (roll < 75)
+        {
+            system.cancelTrip(trips[random() % trips.size()]);
+        }
+        else
+        {
+            system.undoLastAction();
+        }
+    }
+}
+
+// Every resident trip and driver, one per line
+std::string describe(const RideShareSystem &system)
+{
+    std::ostringstream out;
+    for (Trip *trip : system.getAllTrips())
+    {
+        out << "Trip #" << trip->getId() << " " << trip->getStatus() << " driver "
+            << (trip->getDriver() ? trip->getDriver()->getId() : -1) << " fare " << trip->getFare() << "\n";
+    }
+    const DriverStore &drivers = system.getDriverStore();
+    for (size_t i = 0; i < drivers.size(); ++i)
+    {
+        out << "Driver " << i << " at " << drivers.getLocation(i) << (drivers.isAvailable(i) ? " free" : " busy") << "\n";
+    }
+    return out.str();
+}
+
+// The state after each successful undo, until one fails or UNDO_STEPS are
+// done (a freed driver can take a waiting request, pushing a new entry, so
+// the stack need not run dry)
+std::string undoAll(RideShareSystem &system)
+{
+    std::string steps;
+    for (int step = 0; step < UNDO_STEPS && system.undoLastAction(); ++step)
+    {
+        steps += describe(system) + "--\n";
+    }
+    return steps;
+}
+
+// 1 if they differ, with both versions sent to std::clog
+int compare(const std::string &live, const std::string &replayed, const std::string &what)
+{
+    if (live == replayed)
+    {
+        return 0;
+    }
+    std::clog << what << " differs after replay\n--- live\n" << live << "--- replayed\n" << replayed;
+    return 1;
+}
+} // namespace
+
+int main()
+{
+    std::streambuf *out = std::cout.rdbuf(nullptr);
+    std::streambuf *err = std::cerr.rdbuf(nullptr);
+    removeLog(LOG_PATH);
+    removeLog(COPY_PATH);
+
+    int violations = 0;
+    RideShareSystem system;
+    buildCity(system);
+    if (!system.openEventLog(LOG_PATH))
+    {
+        ++violations;
+    }
+    std::vector<Rider *> riders;
+    std::vector<std::mt19937> randoms;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        riders.push_back(system.addRider("Rider", LOCATIONS[t % LOCATION_COUNT]));
+        randoms.push_back(std::mt19937(2000 + t));
+    }
+
+    std::atomic<bool> start(false);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < THREADS; ++t)
+    {
+        workers.push_back(std::thread(runWorker, std::ref(system), riders[t], std::ref(randoms[t]), std::cref(start)));
+    }
+    start = true;
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    // Every change is on disk once its call returns; replay a copy, since
+    // unwinding the live system below logs more
+    {
+        std::ifstream from((std::string(LOG_PATH) + FIRST_SEGMENT).c_str(), std::ios::binary);
+        std::ofstream to((std::string(COPY_PATH) + FIRST_SEGMENT).c_str(), std::ios::binary);
+        to << from.rdbuf();
+    }
+    RideShareSystem replayed;
+    buildCity(replayed);
+    if (!replayed.openEventLog(COPY_PATH))
+    {
+        ++violations;
+    }
+
+    violations += compare(describe(system), describe(replayed), "State");
+    violations += compare(undoAll(system), undoAll(replayed), "Undo stack");
+
+    std::cout.rdbuf(out);
+    std::cerr.rdbuf(err);
+    if (violations > 0)
+    {
+        std::cout << "[ERROR] Replaying the event log did not restore the live state\n";
+        return 1;
+    }
+    std::cout << "[OK] " << THREADS << " threads' bookings and undos replayed to the same state\n";
+    return 0;
+}
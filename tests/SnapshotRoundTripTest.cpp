@@ -0,0 +1,113 @@
+// Takes a snapshot of a system where one driver has a live trip and a
+// finished trip with a higher ID, loads it into a second system, and checks
+// that every trip and every driver's active trip come back as they were.
+
+#include "RideShareSystem.h"
+#include "Driver.h"
+#include "Rider.h"
+#include "Trip.h"
+#include <iostream>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+namespace
+{
+const char *LOG_PATH = "SnapshotRoundTripTest.log";
+const char *SNAPSHOT_PATH = "SnapshotRoundTripTest.snapshot";
+
+void removeFiles()
+{
+    // Taking the snapshot rolls the log to a second segment
+    std::remove((std::string(LOG_PATH) + ".000001").c_str());
+    std::remove((std::string(LOG_PATH) + ".000002").c_str());
+    std::remove(SNAPSHOT_PATH);
+}
+
+// Every resident trip, and each driver's availability and active trip
+std::string describe(const RideShareSystem &system)
+{
+    std::ostringstream out;
+    for (Trip *trip : system.getAllTrips())
+    {
+        out << "Trip #" << trip->getId() << " " << trip->getStateString() << " driver "
+            << (trip->getDriver() ? trip->getDriver()->getId() : -1) << "\n";
+    }
+    const DriverStore &drivers = system.getDriverStore();
+    for (size_t i = 0; i < drivers.size(); ++i)
+    {
+        const Trip *active = system.findDriverActiveTrip(system.getDriverStore().get((int)i));
+        out << "Driver " << i << (drivers.isAvailable(i) ? " free" : " busy") << " on trip "
+            << (active ? active->getId() : -1) << "\n";
+    }
+    return out.str();
+}
+} // namespace
+
+int main()
+{
+    std::streambuf *out = std::cout.rdbuf(nullptr);
+    std::streambuf *err = std::cerr.rdbuf(nullptr);
+    removeFiles();
+
+    int violations = 0;
+    std::string saved;
+    {
+        RideShareSystem system;
+        system.addLocation("A", 1);
+        system.addLocation("B", 1);
+        system.addRoad("A", "B", 5);
+        Driver *driver = system.addDriver("Driver 1", "A", 1);
+        Rider *rider = system.addRider("Rider", "A");
+        system.enableSnapshots(SNAPSHOT_PATH, 0);
+        if (!system.openEventLog(LOG_PATH))
+        {
+            ++violations;
+        }
+
+        // Trip #0 waits in the batch while Trip #1 takes the driver by hand
+        // and finishes; the batch then gives the driver to Trip #0
+        system.enableBatchDispatch(60000);
+        Trip *live = system.requestTrip(rider, "A", "B");
+        Trip *finished = system.requestTrip(rider, "A", "B", driver);
+        system.completeTrip(finished);
+        system.flushDispatchBatch();
+        if (live->getDriver() != driver || finished->getId() < live->getId() ||
+            system.findDriverActiveTrip(driver) != live)
+        {
+            std::clog << "Setup did not leave the driver on the lower-numbered trip\n";
+            ++violations;
+        }
+
+        saved = describe(system);
+        if (!system.takeSnapshot())
+        {
+            ++violations;
+        }
+        system.waitForSnapshot();
+    }
+
+    RideShareSystem restored;
+    restored.enableSnapshots(SNAPSHOT_PATH, 0);
+    if (!restored.loadSnapshot())
+    {
+        ++violations;
+    }
+    std::string loaded = describe(restored);
+    if (loaded != saved)
+    {
+        std::clog << "Snapshot did not round-trip\n--- saved\n" << saved << "--- loaded\n" << loaded;
+        ++violations;
+    }
+    removeFiles();
+
+    std::cout.rdbuf(out);
+    std::cerr.rdbuf(err);
+    if (violations > 0)
+    {
+        std::cout << "[ERROR] Restoring the snapshot changed the trips or drivers\n";
+        return 1;
+    }
+    std::cout << "[OK] Snapshot restored every trip and each driver's active trip\n";
+    return 0;
+}